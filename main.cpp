@@ -1,7 +1,23 @@
-#include "GameWindow.hpp"
-
-int main() {
-    GameWindow game;
-    game.run();
-    return 0;
-}
+#include "GameWindow.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    GameSettings settings;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--ponder") settings.ponder = true;
+        else if (arg == "--threads" && i + 1 < argc && std::atoi(argv[i + 1]) > 0) settings.threads = std::atoi(argv[++i]);
+        else {
+            std::cout << "Usage: ajedrez [--ponder] [--threads N]\n"
+                      << "  --ponder      let the AI think on the expected reply during the player's turn\n"
+                      << "  --threads N   search threads for the AI (default 1)\n";
+            return 2;
+        }
+    }
+
+    GameWindow game(settings);
+    game.run();
+    return 0;
+}
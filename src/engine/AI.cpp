@@ -1,205 +1,759 @@
-#include "AI.hpp"
-#include <algorithm>
-#include <limits>
-#include <chrono>
-
-// Piece-Square Tables (from the perspective of White, will be flipped for Black)
-const int pawnPST[8][8] = {
-    { 0,  0,  0,  0,  0,  0,  0,  0},
-    {50, 50, 50, 50, 50, 50, 50, 50},
-    {10, 10, 20, 30, 30, 20, 10, 10},
-    { 5,  5, 10, 25, 25, 10,  5,  5},
-    { 0,  0,  0, 20, 20,  0,  0,  0},
-    { 5, -5,-10,  0,  0,-10, -5,  5},
-    { 5, 10, 10,-20,-20, 10, 10,  5},
-    { 0,  0,  0,  0,  0,  0,  0,  0}
-};
-
-const int knightPST[8][8] = {
-    {-50,-40,-30,-30,-30,-30,-40,-50},
-    {-40,-20,  0,  0,  0,  0,-20,-40},
-    {-30,  0, 10, 15, 15, 10,  0,-30},
-    {-30,  5, 15, 20, 20, 15,  5,-30},
-    {-30,  0, 15, 20, 20, 15,  0,-30},
-    {-30,  5, 10, 15, 15, 10,  5,-30},
-    {-40,-20,  0,  5,  5,  0,-20,-40},
-    {-50,-40,-30,-30,-30,-30,-40,-50}
-};
-
-const int bishopPST[8][8] = {
-    {-20,-10,-10,-10,-10,-10,-10,-20},
-    {-10,  0,  0,  0,  0,  0,  0,-10},
-    {-10,  0,  5, 10, 10,  5,  0,-10},
-    {-10,  5,  5, 10, 10,  5,  5,-10},
-    {-10,  0, 10, 10, 10, 10,  0,-10},
-    {-10, 10, 10, 10, 10, 10, 10,-10},
-    {-10,  5,  0,  0,  0,  0,  5,-10},
-    {-20,-10,-10,-10,-10,-10,-10,-20}
-};
-
-const int rookPST[8][8] = {
-    { 0,  0,  0,  0,  0,  0,  0,  0},
-    { 5, 10, 10, 10, 10, 10, 10,  5},
-    {-5,  0,  0,  0,  0,  0,  0, -5},
-    {-5,  0,  0,  0,  0,  0,  0, -5},
-    {-5,  0,  0,  0,  0,  0,  0, -5},
-    {-5,  0,  0,  0,  0,  0,  0, -5},
-    {-5,  0,  0,  0,  0,  0,  0, -5},
-    { 0,  0,  0,  5,  5,  0,  0,  0}
-};
-
-const int queenPST[8][8] = {
-    {-20,-10,-10, -5, -5,-10,-10,-20},
-    {-10,  0,  0,  0,  0,  0,  0,-10},
-    {-10,  0,  5,  5,  5,  5,  0,-10},
-    { -5,  0,  5,  5,  5,  5,  0, -5},
-    {  0,  0,  5,  5,  5,  5,  0, -5},
-    {-10,  5,  5,  5,  5,  5,  0,-10},
-    {-10,  0,  5,  0,  0,  0,  0,-10},
-    {-20,-10,-10, -5, -5,-10,-10,-20}
-};
-
-const int kingPST[8][8] = {
-    {-30,-40,-40,-50,-50,-40,-40,-30},
-    {-30,-40,-40,-50,-50,-40,-40,-30},
-    {-30,-40,-40,-50,-50,-40,-40,-30},
-    {-30,-40,-40,-50,-50,-40,-40,-30},
-    {-20,-30,-30,-40,-40,-30,-30,-20},
-    {-10,-20,-20,-20,-20,-20,-20,-10},
-    { 20, 20,  0,  0,  0,  0, 20, 20},
-    { 20, 30, 10,  0,  0, 10, 30, 20}
-};
-
-AI::AI(PieceColor color) : aiColor(color) {
-    rng.seed(std::chrono::steady_clock::now().time_since_epoch().count());
-}
-
-int AI::evaluate(const Board& board) {
-    int score = 0;
-    for (int i = 0; i < 8; i++) {
-        for (int j = 0; j < 8; j++) {
-            Piece p = board.getPiece(i, j);
-            if (p.type == PieceType::None) continue;
-            
-            int value = 0;
-            int posBonus = 0;
-            
-            // Flip coordinates for Black PST
-            int r = (p.color == PieceColor::White) ? j : 7 - j;
-            int c = i;
-
-            switch (p.type) {
-                case PieceType::Pawn: 
-                    value = 100; 
-                    posBonus = pawnPST[r][c];
-                    break;
-                case PieceType::Knight: 
-                    value = 320; 
-                    posBonus = knightPST[r][c];
-                    break;
-                case PieceType::Bishop: 
-                    value = 330; 
-                    posBonus = bishopPST[r][c];
-                    break;
-                case PieceType::Rook: 
-                    value = 500; 
-                    posBonus = rookPST[r][c];
-                    break;
-                case PieceType::Queen: 
-                    value = 900; 
-                    posBonus = queenPST[r][c];
-                    break;
-                case PieceType::King: 
-                    value = 20000; 
-                    posBonus = kingPST[r][c];
-                    break;
-                default: break;
-            }
-            
-            if (p.color == aiColor) score += (value + posBonus);
-            else score -= (value + posBonus);
-        }
-    }
-    return score;
-}
-
-Move AI::getBestMove(Board board, int depth) {
-    int bestScore = std::numeric_limits<int>::min();
-    std::vector<Move> bestMoves;
-
-    for (int sx = 0; sx < 8; sx++) {
-        for (int sy = 0; sy < 8; sy++) {
-            if (board.getPiece(sx, sy).color != aiColor) continue;
-            for (int ex = 0; ex < 8; ex++) {
-                for (int ey = 0; ey < 8; ey++) {
-                    if (board.isLegalMove(sx, sy, ex, ey)) {
-                        Board nextBoard = board;
-                        nextBoard.movePiece(sx, sy, ex, ey);
-                        int score = minimax(nextBoard, depth - 1, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), false);
-                        
-                        if (score > bestScore) {
-                            bestScore = score;
-                            bestMoves.clear();
-                            bestMoves.push_back({sx, sy, ex, ey, bestScore});
-                        } else if (score == bestScore) {
-                            bestMoves.push_back({sx, sy, ex, ey, bestScore});
-                        }
-                    }
-                }
-            }
-        }
-    }
-    
-    if (bestMoves.empty()) return {-1, -1, -1, -1, 0};
-    
-    std::uniform_int_distribution<int> dist(0, bestMoves.size() - 1);
-    return bestMoves[dist(rng)];
-}
-
-int AI::minimax(Board board, int depth, int alpha, int beta, bool maximizingPlayer) {
-    if (depth == 0) return evaluate(board);
-
-    PieceColor currentTurn = board.getTurn();
-    
-    if (maximizingPlayer) {
-        int maxEval = std::numeric_limits<int>::min();
-        for (int sx = 0; sx < 8; sx++) {
-            for (int sy = 0; sy < 8; sy++) {
-                if (board.getPiece(sx, sy).color != currentTurn) continue;
-                for (int ex = 0; ex < 8; ex++) {
-                    for (int ey = 0; ey < 8; ey++) {
-                        if (board.isLegalMove(sx, sy, ex, ey)) {
-                            Board nextBoard = board;
-                            nextBoard.movePiece(sx, sy, ex, ey);
-                            int eval = minimax(nextBoard, depth - 1, alpha, beta, false);
-                            maxEval = std::max(maxEval, eval);
-                            alpha = std::max(alpha, eval);
-                            if (beta <= alpha) break;
-                        }
-                    }
-                }
-            }
-        }
-        return maxEval;
-    } else {
-        int minEval = std::numeric_limits<int>::max();
-        for (int sx = 0; sx < 8; sx++) {
-            for (int sy = 0; sy < 8; sy++) {
-                if (board.getPiece(sx, sy).color != currentTurn) continue;
-                for (int ex = 0; ex < 8; ex++) {
-                    for (int ey = 0; ey < 8; ey++) {
-                        if (board.isLegalMove(sx, sy, ex, ey)) {
-                            Board nextBoard = board;
-                            nextBoard.movePiece(sx, sy, ex, ey);
-                            int eval = minimax(nextBoard, depth - 1, alpha, beta, true);
-                            minEval = std::min(minEval, eval);
-                            beta = std::min(beta, eval);
-                            if (beta <= alpha) break;
-                        }
-                    }
-                }
-            }
-        }
-        return minEval;
-    }
-}
+#include "AI.hpp"
+#include "Bitbases.hpp"
+#include "Notation.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+// Search limits are checked every this many nodes; a power of two
+const int NODE_CHECK_INTERVAL = 2048;
+
+// Move ordering bands: hash move, captures and promotions (MVV-LVA), killers, then
+// quiet moves by history score, which is kept below HISTORY_MAX
+const int HASH_MOVE_SCORE = 4000000;
+const int CAPTURE_SCORE = 2000000;
+const int KILLER_SCORE = 1000000;
+const int HISTORY_MAX = 500000;
+// A capture that cannot lift the stand-pat score to within this margin of alpha
+// is not searched in quiescence
+const int DELTA_MARGIN = 200;
+// Search window bounds; symmetric so that negating a score never overflows
+const int INFINITE_SCORE = MATE_SCORE + 1;
+// Aspiration window half-width around the previous iteration's score, widened
+// on every fail high or low
+const int ASPIRATION_WINDOW = 25;
+const int ASPIRATION_MIN_DEPTH = 4;
+// Null-move pruning depth limits; from NULL_VERIFY_DEPTH on a null-move cutoff
+// is confirmed by a reduced normal search
+const int NULL_MOVE_MIN_DEPTH = 3;
+const int NULL_VERIFY_DEPTH = 8;
+// Late move reductions start at this depth and move number
+const int LMR_MIN_DEPTH = 3;
+const int LMR_MIN_MOVES = 3;
+// Bitbase wins score above any material balance but below mate scores, plus a
+// bonus for progress so the search still drives towards mate or promotion
+const int KNOWN_WIN = 10000;
+
+namespace {
+
+// The table stores mate scores relative to the node, not the root, so they stay
+// valid when the same position is reached at a different ply.
+int scoreToTT(int score, int ply) {
+    if (score > MATE_BOUND) return score + ply;
+    if (score < -MATE_BOUND) return score - ply;
+    return score;
+}
+
+int scoreFromTT(int score, int ply) {
+    if (score > MATE_BOUND) return score - ply;
+    if (score < -MATE_BOUND) return score + ply;
+    return score;
+}
+
+// Late move reduction in plies by remaining depth and move number: grows with
+// the logarithm of both, so early moves and shallow nodes are barely reduced
+struct ReductionTable {
+    int table[MAX_PLY][64];
+    ReductionTable() {
+        for (int d = 0; d < MAX_PLY; d++) {
+            for (int i = 0; i < 64; i++) {
+                table[d][i] = (d == 0 || i == 0) ? 0 : static_cast<int>(0.75 + std::log(d) * std::log(i) / 2.25);
+            }
+        }
+    }
+    int at(int depth, int moveNumber) const { return table[std::min(depth, MAX_PLY - 1)][std::min(moveNumber, 63)]; }
+};
+const ReductionTable reductions;
+
+// Victim and attacker values for MVV-LVA, indexed by typeIndex
+const int orderValue[6] = {1, 3, 3, 5, 9, 10};
+
+bool isQuiet(const Board& board, const Move& m) {
+    if (m.promotion != PieceType::None) return false;
+    int to = makeSquare(m.endX, m.endY);
+    if (board.pieceOn(to).type != PieceType::None) return false;
+    return !(to == board.getEnPassantSquare() && board.getPiece(m.startX, m.startY).type == PieceType::Pawn);
+}
+
+// Moves the highest scored move from i onwards into slot i. Picking lazily is
+// cheaper than sorting because most nodes cut off after a move or two.
+const Move& pickMove(MoveList& moves, int i) {
+    int best = i;
+    for (int j = i + 1; j < moves.size(); j++) {
+        if (moves[j].score > moves[best].score) best = j;
+    }
+    std::swap(moves[i], moves[best]);
+    return moves[i];
+}
+
+// Board keeps the material and piece-square sums up to date as moves are made;
+// the pawn structure comes from the pawn table
+int whiteScore(const Board& board, PawnTable& pawns, bool& pawnHit) {
+    Psqt::Score score = board.psqt(PieceColor::White);
+    score -= board.psqt(PieceColor::Black);
+    score += pawns.probe(board, pawnHit);
+    return Psqt::taper(score, board.gamePhase());
+}
+
+// The network's score, from the side to move's point of view, kept below the
+// bitbase wins whatever the weights
+int networkScore(const Board& board) {
+    return std::max(-KNOWN_WIN + 1, std::min(Nnue::evaluate(board), KNOWN_WIN - 1));
+}
+
+// Rewards cornering the lone king, bringing the kings together and pushing the
+// pawn, on top of the material and piece-square balance so a promotion gains.
+int winningProgress(const Board& board, PieceColor strong) {
+    const int winner = board.kingSquare(strong);
+    const int loser = board.kingSquare(opponent(strong));
+    const int edge = std::max(std::abs(2 * (loser & 7) - 7), std::abs(2 * (loser >> 3) - 7)) / 2;
+    const int distance = std::max(std::abs((winner & 7) - (loser & 7)), std::abs((winner >> 3) - (loser >> 3)));
+    Psqt::Score balance = board.psqt(strong);
+    balance -= board.psqt(opponent(strong));
+    int progress = Psqt::taper(balance, board.gamePhase()) + 20 * edge + 10 * (7 - distance);
+    Bitboard pawns = board.pieces(strong, PieceType::Pawn);
+    if (pawns) {
+        int rank = Bitboards::lsb(pawns) >> 3;
+        progress += 20 * (strong == PieceColor::White ? rank : 7 - rank);
+    }
+    return progress;
+}
+
+}
+
+double SearchStats::branchingFactor() const {
+    const std::size_t n = iterations.size();
+    if (n < 3) return 0;
+    // Nodes spent on each of the last two iterations, not the running totals
+    const double last = static_cast<double>(iterations[n - 1].nodes - iterations[n - 2].nodes);
+    const double previous = static_cast<double>(iterations[n - 2].nodes - iterations[n - 3].nodes);
+    return previous > 0 ? last / previous : 0;
+}
+
+std::string toJson(const SearchResult& result) {
+    const SearchStats& s = result.stats;
+    std::ostringstream out;
+    out << "{\"bestmove\":\"" << (result.bestMove.startX >= 0 ? moveToUci(result.bestMove) : "") << "\""
+        << ",\"score\":" << result.score
+        << ",\"depth\":" << result.depth
+        << ",\"nodes\":" << result.nodes
+        << ",\"time_ms\":" << result.timeMs
+        << ",\"nps\":" << (result.timeMs > 0 ? result.nodes * 1000 / result.timeMs : 0)
+        << ",\"pv\":\"";
+    for (std::size_t i = 0; i < result.pv.size(); i++) out << (i ? " " : "") << moveToUci(result.pv[i]);
+    out << "\"";
+
+    if (SEARCH_STATS_ENABLED) {
+        out << ",\"qnodes\":" << s.qnodes
+            << ",\"beta_cutoffs\":" << s.betaCutoffs
+            << ",\"first_move_cutoff_rate\":" << s.firstMoveCutoffRate()
+            << ",\"tt_probes\":" << s.ttProbes
+            << ",\"tt_hit_rate\":" << s.ttHitRate()
+            << ",\"tt_cutoffs\":" << s.ttCutoffs
+            << ",\"bitbase_hits\":" << s.bitbaseHits
+            << ",\"pawn_hit_rate\":" << s.pawnHitRate()
+            << ",\"branching_factor\":" << s.branchingFactor()
+            << ",\"iterations\":[";
+        for (std::size_t i = 0; i < s.iterations.size(); i++) {
+            const IterationStats& it = s.iterations[i];
+            out << (i ? "," : "") << "{\"depth\":" << it.depth << ",\"nodes\":" << it.nodes
+                << ",\"time_ms\":" << it.timeMs << ",\"score\":" << it.score << "}";
+        }
+        out << "]";
+    }
+    out << "}";
+    return out.str();
+}
+
+std::string jsonString(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) out += c;
+    }
+    return out + "\"";
+}
+
+AI::AI(PieceColor color) : aiColor(color) {
+    rng.seed(std::chrono::steady_clock::now().time_since_epoch().count());
+}
+
+bool AI::loadBook(const std::string& path) {
+    stop();
+    waitForSearch();
+    return book.open(path);
+}
+
+void AI::setHashSize(int megabytes) {
+    stop();
+    waitForSearch();
+    tt.resize(megabytes > 0 ? megabytes : 1);
+}
+
+void AI::clearHash() {
+    stop();
+    waitForSearch();
+    tt.clear();
+}
+
+void AI::setUseNnue(bool use) {
+    stop();
+    waitForSearch();
+    useNnue = use;
+}
+
+int AI::evaluate(const Board& board) const {
+    if (usesNnue()) {
+        int value = networkScore(board);
+        return board.getTurn() == aiColor ? value : -value;
+    }
+    bool hit;
+    int value = whiteScore(board, pawnTable, hit);
+    return aiColor == PieceColor::White ? value : -value;
+}
+
+void AI::scoreMoves(const SearchThread& t, MoveList& moves, const Move& hashMove, int ply) const {
+    const Board& board = t.board;
+    const int side = colorIndex(board.getTurn());
+    for (Move& m : moves) {
+        int from = makeSquare(m.startX, m.startY);
+        int to = makeSquare(m.endX, m.endY);
+        if (m == hashMove) {
+            m.score = HASH_MOVE_SCORE;
+        } else if (!isQuiet(board, m)) {
+            // Most valuable victim first, least valuable attacker breaks ties
+            Piece victim = board.pieceOn(to);
+            int victimValue = victim.type != PieceType::None ? orderValue[typeIndex(victim.type)] : orderValue[0];
+            if (m.promotion != PieceType::None) victimValue += orderValue[typeIndex(m.promotion)];
+            m.score = CAPTURE_SCORE + victimValue * 16 - orderValue[typeIndex(board.pieceOn(from).type)];
+        } else if (m == t.killers[ply][0]) {
+            m.score = KILLER_SCORE + 1;
+        } else if (m == t.killers[ply][1]) {
+            m.score = KILLER_SCORE;
+        } else {
+            m.score = t.history[side][from][to];
+        }
+    }
+}
+
+void AI::updateQuietStats(SearchThread& t, const Move& m, int depth, int ply) {
+    if (m != t.killers[ply][0]) {
+        t.killers[ply][1] = t.killers[ply][0];
+        t.killers[ply][0] = m;
+    }
+
+    int side = colorIndex(t.board.getTurn());
+    int& entry = t.history[side][makeSquare(m.startX, m.startY)][makeSquare(m.endX, m.endY)];
+    entry += depth * depth;
+    if (entry >= HISTORY_MAX) {
+        // Halve the whole table so older cutoffs fade and scores stay in their band
+        for (auto& from : t.history) {
+            for (auto& to : from) {
+                for (int& h : to) h /= 2;
+            }
+        }
+    }
+}
+
+Move AI::getBestMove(Board board, int depth) {
+    SearchLimits limits;
+    limits.depth = depth;
+    return search(board, limits).bestMove;
+}
+
+AI::~AI() {
+    stop();
+    waitForSearch();
+}
+
+int AI::elapsedMs() const {
+    std::chrono::steady_clock::duration start(startTime.load(std::memory_order_relaxed));
+    return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch() - start).count());
+}
+
+void AI::allocateTime(const SearchLimits& limits) {
+    softTimeMs = hardTimeMs = 0;
+    if (limits.infinite) return;
+    if (limits.moveTime > 0) {
+        hardTimeMs = limits.moveTime;
+        return;
+    }
+
+    int remaining = (aiColor == PieceColor::White) ? limits.whiteTime : limits.blackTime;
+    int increment = (aiColor == PieceColor::White) ? limits.whiteIncrement : limits.blackIncrement;
+    if (remaining <= 0) return;
+
+    // Spread the clock over the moves left, keep a margin for move overhead,
+    // and never let one move use more than a third of what is left
+    const int overhead = 50;
+    int movesLeft = limits.movesToGo > 0 ? limits.movesToGo : 30;
+    int usable = std::max(1, remaining - overhead);
+    softTimeMs = std::min(usable, usable / movesLeft + increment * 3 / 4);
+    hardTimeMs = std::min(usable / 3 + increment, softTimeMs * 4);
+    hardTimeMs = std::max(hardTimeMs, softTimeMs);
+}
+
+void AI::checkLimits(SearchThread& t) {
+    // Nodes are published in batches so threads do not contend on one counter
+    std::uint64_t total = nodesSearched.fetch_add(NODE_CHECK_INTERVAL, std::memory_order_relaxed) + NODE_CHECK_INTERVAL;
+    if (stopRequested.load(std::memory_order_relaxed)) t.stopped = true;
+    else if (nodeLimit && total >= nodeLimit) t.stopped = true;
+    else if (hardTimeMs && !pondering.load(std::memory_order_relaxed) && elapsedMs() >= hardTimeMs) t.stopped = true;
+}
+
+void AI::setThreads(int count) {
+    stop();
+    waitForSearch();
+    threadCount = std::max(1, std::min(count, 256));
+}
+
+void AI::ponderHit() {
+    startTime = std::chrono::steady_clock::now().time_since_epoch().count();
+    pondering = false;
+}
+
+void AI::waitForSearch() {
+    if (searchThread.joinable()) searchThread.join();
+}
+
+std::future<SearchResult> AI::searchAsync(const Board& board, const SearchLimits& limits) {
+    stop();
+    waitForSearch();
+
+    // Reset here rather than in the worker so a stop() right after this call is not lost
+    stopRequested = false;
+    pondering = limits.ponder;
+    searching = true;
+    std::promise<SearchResult> promise;
+    std::future<SearchResult> future = promise.get_future();
+    searchThread = std::thread([this, board, limits, promise = std::move(promise)]() mutable {
+        SearchResult result = runSearch(board, limits);
+        searching = false;
+        promise.set_value(result);
+    });
+    return future;
+}
+
+SearchResult AI::search(const Board& board, const SearchLimits& limits) {
+    stop();
+    waitForSearch();
+    stopRequested = false;
+    pondering = limits.ponder;
+    return runSearch(board, limits);
+}
+
+SearchResult AI::runSearch(const Board& rootBoard, const SearchLimits& limits) {
+    // Scores and the clock are always those of the side to move
+    aiColor = rootBoard.getTurn();
+    Bitbases::Result rootResult;
+    rootInBitbase = Bitbases::probe(rootBoard, rootResult);
+    startTime = std::chrono::steady_clock::now().time_since_epoch().count();
+
+    Move bookMove;
+    if (!limits.infinite && book.probe(rootBoard, rng(), bookMove)) {
+        SearchResult result;
+        result.bestMove = bookMove;
+        result.pv.assign(1, bookMove);
+        result.timeMs = elapsedMs();
+        lastStats = SearchStats();
+        return result;
+    }
+
+    nodesSearched = 0;
+    nodeLimit = limits.nodes;
+    allocateTime(limits);
+    tt.newSearch();
+
+    while (static_cast<int>(threads.size()) < threadCount) {
+        threads.push_back(std::unique_ptr<SearchThread>(new SearchThread()));
+        threads.back()->id = static_cast<int>(threads.size()) - 1;
+        threads.back()->rng.seed(rng());
+    }
+    for (int i = 0; i < threadCount; i++) {
+        SearchThread& t = *threads[i];
+        t.board = rootBoard;
+        t.nodes = 0;
+        t.stopped = false;
+        t.previousPv.clear();
+        t.result = SearchResult();
+        t.stats = SearchStats();
+        for (auto& k : t.killers) k[0] = k[1] = Move{-1, -1, -1, -1, 0};
+        for (auto& side : t.history) {
+            for (auto& from : side) {
+                for (int& h : from) h = 0;
+            }
+        }
+    }
+
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < threadCount; i++) {
+        helpers.emplace_back(&AI::iterativeDeepening, this, std::ref(*threads[i]), std::cref(limits));
+    }
+    iterativeDeepening(*threads[0], limits);
+
+    // The main thread decides when the search is over
+    stopRequested = true;
+    for (std::thread& h : helpers) h.join();
+
+    // Prefer a helper that completed a deeper iteration than the main thread
+    SearchResult result = threads[0]->result;
+    std::uint64_t totalNodes = 0;
+    SearchStats totalStats;
+    for (int i = 0; i < threadCount; i++) {
+        const SearchResult& r = threads[i]->result;
+        totalNodes += threads[i]->nodes;
+        totalStats.add(threads[i]->stats);
+        if (r.depth > result.depth && r.bestMove.startX >= 0) result = r;
+    }
+    totalStats.iterations = threads[0]->stats.iterations;
+    result.nodes = totalNodes;
+    result.stats = totalStats;
+    result.timeMs = elapsedMs();
+    lastStats = totalStats;
+    return result;
+}
+
+void AI::iterativeDeepening(SearchThread& t, const SearchLimits& limits) {
+    // Helpers skip some depths so that the threads spread over different
+    // iterations instead of all searching the same tree in lockstep
+    static const int skipSize[] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+    static const int skipPhase[] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+    const bool mainThread = (t.id == 0);
+    const int maxDepth = (limits.depth > 0) ? std::min(limits.depth, MAX_PLY - 4) : MAX_PLY - 4;
+    SearchResult& result = t.result;
+
+    for (int depth = 1; depth <= maxDepth; depth++) {
+        if (!mainThread && depth > 1) {
+            int i = (t.id - 1) % 20;
+            if (((depth + skipPhase[i]) / skipSize[i]) % 2) continue;
+        }
+
+        // Aspiration window around the last score. A score on or beyond an edge is
+        // only a bound, so that edge is widened and the depth searched again.
+        int delta = ASPIRATION_WINDOW;
+        int alpha = -INFINITE_SCORE;
+        int beta = INFINITE_SCORE;
+        if (depth >= ASPIRATION_MIN_DEPTH && result.depth > 0 && std::abs(result.score) < KNOWN_WIN) {
+            alpha = result.score - delta;
+            beta = result.score + delta;
+        }
+        SearchResult iteration;
+        for (;;) {
+            iteration = searchRoot(t, depth, alpha, beta);
+            if (t.stopped) break;
+            if (iteration.score <= alpha && alpha > -INFINITE_SCORE) alpha = std::max(-INFINITE_SCORE, alpha - delta);
+            else if (iteration.score >= beta && beta < INFINITE_SCORE) beta = std::min(INFINITE_SCORE, beta + delta);
+            else break;
+            delta *= 2;
+        }
+        // A stopped iteration is incomplete; keep the last full one. Depth 1
+        // always counts so there is a move to play.
+        if (t.stopped && result.depth > 0) break;
+        result = iteration;
+        if (result.bestMove.startX < 0) break;
+        t.previousPv = result.pv;
+        if (t.stopped || !mainThread) continue;
+
+        const std::uint64_t nodesSoFar = nodesSearched.load(std::memory_order_relaxed) + (t.nodes & (NODE_CHECK_INTERVAL - 1));
+        SEARCH_STAT(t.stats.iterations.push_back({depth, nodesSoFar, elapsedMs(), result.score}));
+        if (infoCallback) {
+            SearchResult info = result;
+            info.nodes = nodesSoFar;
+            info.timeMs = elapsedMs();
+            info.stats = t.stats;
+            infoCallback(info);
+        }
+
+        // Stop when a forced mate is proven or the next iteration is unlikely to finish
+        // in time. A ponder search keeps going until it is hit or stopped.
+        if (limits.infinite || pondering) continue;
+        if (std::abs(result.score) > MATE_BOUND) break;
+        if (softTimeMs && elapsedMs() >= softTimeMs / 2) break;
+    }
+}
+
+SearchResult AI::searchRoot(SearchThread& t, int depth, int alpha, int beta) {
+    Board& board = t.board;
+    SearchResult result;
+    result.depth = depth;
+
+    MoveList moves;
+    board.generateMoves(moves);
+    if (moves.empty()) return result;
+
+    // The previous iteration's best line goes first
+    t.followPv = !t.previousPv.empty();
+    scoreMoves(t, moves, t.followPv ? t.previousPv[0] : Move{-1, -1, -1, -1, 0}, 0);
+
+    int bestScore = -INFINITE_SCORE;
+    std::vector<Move> bestMoves;
+    std::vector<std::vector<Move>> bestLines;
+
+    for (int i = 0; i < moves.size(); i++) {
+        const Move& m = pickMove(moves, i);
+        board.makeMove(m);
+        // One point below the best so far, so moves that tie it come back exact
+        int floor = (bestScore == -INFINITE_SCORE) ? alpha : std::max(alpha, bestScore - 1);
+        t.pvLength[1] = 1;
+        int score;
+        if (i == 0) {
+            score = -negamax(t, depth - 1, 1, -beta, -floor, true);
+        } else {
+            // Later moves only have to show they are no better than the first
+            score = -negamax(t, depth - 1, 1, -floor - 1, -floor, true);
+            if (score > floor && score < beta && !t.stopped) score = -negamax(t, depth - 1, 1, -beta, -floor, true);
+        }
+        board.unmakeMove();
+        if (i == 0) t.followPv = false;
+        if (t.stopped) break;
+
+        if (score >= bestScore) {
+            if (score > bestScore) {
+                bestMoves.clear();
+                bestLines.clear();
+            }
+            bestScore = score;
+            bestMoves.push_back({m.startX, m.startY, m.endX, m.endY, score, m.promotion});
+            std::vector<Move> line(1, m);
+            line.insert(line.end(), t.pvTable[1] + 1, t.pvTable[1] + t.pvLength[1]);
+            bestLines.push_back(line);
+        }
+        if (bestScore >= beta) break;
+    }
+
+    if (bestMoves.empty()) {
+        // Stopped before the first move finished
+        result.bestMove = moves[0];
+        result.pv.assign(1, moves[0]);
+        return result;
+    }
+
+    std::uniform_int_distribution<int> dist(0, bestMoves.size() - 1);
+    int pick = dist(t.rng);
+    result.bestMove = bestMoves[pick];
+    result.score = bestScore;
+    result.pv = bestLines[pick];
+    Bound bound = bestScore <= alpha ? Bound::Upper : (bestScore >= beta ? Bound::Lower : Bound::Exact);
+    tt.store(board.getHash(), result.bestMove, bestScore, depth, bound);
+    return result;
+}
+
+int AI::staticEval(SearchThread& t) const {
+    if (usesNnue()) return networkScore(t.board);
+    bool hit;
+    int value = whiteScore(t.board, t.pawns, hit);
+    SEARCH_STAT(t.stats.pawnProbes++);
+    SEARCH_STAT(t.stats.pawnHits += hit);
+    return t.board.getTurn() == PieceColor::White ? value : -value;
+}
+
+int AI::negamax(SearchThread& t, int depth, int ply, int alpha, int beta, bool nullAllowed) {
+    Board& board = t.board;
+    t.pvLength[ply] = ply;
+    if ((++t.nodes & (NODE_CHECK_INTERVAL - 1)) == 0) checkLimits(t);
+    if (t.stopped) return 0;
+    if (ply >= MAX_PLY - 1) return staticEval(t);
+
+    // Once a capture reaches a covered ending the subtree below it is known
+    int bitbaseScore;
+    if (probeBitbase(t, ply, bitbaseScore) && (bitbaseScore == 0 || !rootInBitbase)) return bitbaseScore;
+
+    // Checks are searched one ply deeper so the horizon does not hide their answer
+    const PieceColor turn = board.getTurn();
+    const bool inCheck = board.checkers() != 0;
+    if (inCheck) depth++;
+    if (depth <= 0) return quiescence(t, ply, alpha, beta);
+
+    const bool pvNode = beta - alpha > 1;
+    const std::uint64_t key = board.getHash();
+    const int alphaOrig = alpha;
+    Move hashMove = {-1, -1, -1, -1, 0};
+    TTData entry;
+    SEARCH_STAT(t.stats.ttProbes++);
+    if (tt.probe(key, entry)) {
+        SEARCH_STAT(t.stats.ttHits++);
+        hashMove = entry.move;
+        // Principal variation nodes keep searching so the line stays complete
+        if (entry.depth >= depth && !pvNode && !t.followPv) {
+            int score = scoreFromTT(entry.score, ply);
+            if (entry.bound == Bound::Exact ||
+                (entry.bound == Bound::Lower && score >= beta) ||
+                (entry.bound == Bound::Upper && score <= alpha)) {
+                SEARCH_STAT(t.stats.ttCutoffs++);
+                return score;
+            }
+        }
+    }
+
+    // Null move: if passing still fails high, a real move almost certainly would.
+    // Not in check, and only with pieces left, since in pawn endings passing may
+    // be the best move there is (zugzwang).
+    const Bitboard pieces = board.pieces(turn) & ~board.pieces(turn, PieceType::Pawn) & ~board.pieces(turn, PieceType::King);
+    if (nullAllowed && !pvNode && !inCheck && depth >= NULL_MOVE_MIN_DEPTH && pieces &&
+        std::abs(beta) < KNOWN_WIN && staticEval(t) >= beta) {
+        const int reduction = 3 + depth / 6;
+        board.makeNullMove();
+        int score = -negamax(t, depth - 1 - reduction, ply + 1, -beta, -beta + 1, false);
+        board.unmakeNullMove();
+        if (t.stopped) return 0;
+        if (score >= beta) {
+            // Unproven mates are not trusted; deep cutoffs are verified with a
+            // reduced search of our own moves in case this is zugzwang after all
+            if (score >= KNOWN_WIN) score = beta;
+            if (depth < NULL_VERIFY_DEPTH) return score;
+            if (negamax(t, depth - 1 - reduction, ply, beta - 1, beta, false) >= beta) return score;
+        }
+    }
+
+    MoveList moves;
+    board.generateMoves(moves);
+    if (moves.empty()) {
+        // Checkmate scores prefer the shortest mate; stalemate is a draw
+        return inCheck ? -MATE_SCORE + ply : 0;
+    }
+
+    // Search the previous principal variation first, otherwise the move the table remembers
+    bool pvChild = false;
+    if (t.followPv && ply < static_cast<int>(t.previousPv.size())) {
+        for (const Move& m : moves) {
+            if (m == t.previousPv[ply]) {
+                hashMove = m;
+                pvChild = true;
+                break;
+            }
+        }
+    }
+    t.followPv = pvChild;
+    scoreMoves(t, moves, hashMove, ply);
+
+    int bestScore = -INFINITE_SCORE;
+    Move bestMove = {-1, -1, -1, -1, 0};
+    for (int i = 0; i < moves.size(); i++) {
+        const Move m = pickMove(moves, i);
+        const bool quiet = isQuiet(board, m);
+        board.makeMove(m);
+        const bool givesCheck = board.checkers() != 0;
+
+        int score;
+        if (i == 0) {
+            score = -negamax(t, depth - 1, ply + 1, -beta, -alpha, true);
+        } else {
+            // Late quiet moves are searched shallower; the further down the
+            // ordering and the worse their history, the bigger the reduction
+            int reduction = 0;
+            if (depth >= LMR_MIN_DEPTH && i >= LMR_MIN_MOVES && quiet && !inCheck && !givesCheck &&
+                m.score < KILLER_SCORE) {
+                reduction = reductions.at(depth, i);
+                if (pvNode) reduction--;
+                if (m.score > HISTORY_MAX / 2) reduction--;
+                reduction = std::max(0, std::min(reduction, depth - 2));
+            }
+            // Null window: the move only needs to be shown no better than alpha
+            score = -negamax(t, depth - 1 - reduction, ply + 1, -alpha - 1, -alpha, true);
+            if (reduction && score > alpha && !t.stopped) {
+                score = -negamax(t, depth - 1, ply + 1, -alpha - 1, -alpha, true);
+            }
+            if (score > alpha && score < beta && !t.stopped) {
+                score = -negamax(t, depth - 1, ply + 1, -beta, -alpha, true);
+            }
+        }
+        board.unmakeMove();
+        t.followPv = false;
+        if (t.stopped) return 0;
+
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = m;
+        }
+        if (score > alpha) {
+            alpha = score;
+            t.pvTable[ply][ply] = m;
+            for (int j = ply + 1; j < t.pvLength[ply + 1]; j++) t.pvTable[ply][j] = t.pvTable[ply + 1][j];
+            t.pvLength[ply] = std::max(t.pvLength[ply + 1], ply + 1);
+        }
+        if (alpha >= beta) {
+            SEARCH_STAT(t.stats.betaCutoffs++);
+            SEARCH_STAT(t.stats.firstMoveCutoffs += (i == 0));
+            if (quiet) updateQuietStats(t, m, depth, ply);
+            break;
+        }
+    }
+
+    Bound bound = bestScore <= alphaOrig ? Bound::Upper : (bestScore >= beta ? Bound::Lower : Bound::Exact);
+    tt.store(key, bestMove, scoreToTT(bestScore, ply), depth, bound);
+    return bestScore;
+}
+
+bool AI::probeBitbase(SearchThread& t, int ply, int& score) {
+    const Board& board = t.board;
+    if (Bitboards::popCount(board.occupancy()) > 3) return false;
+    Bitbases::Result result;
+    if (!Bitbases::probe(board, result)) return false;
+    SEARCH_STAT(t.stats.bitbaseHits++);
+
+    // Only an actual mate on the board needs a mate score
+    const PieceColor turn = board.getTurn();
+    score = 0;
+    if (result == Bitbases::Result::Win) {
+        score = KNOWN_WIN + winningProgress(board, turn);
+    } else if (result == Bitbases::Result::Loss) {
+        if (board.isInCheck(turn) && !board.hasLegalMoves(turn)) score = -MATE_SCORE + ply;
+        else score = -KNOWN_WIN - winningProgress(board, opponent(turn));
+    }
+    return true;
+}
+
+int AI::quiescence(SearchThread& t, int ply, int alpha, int beta) {
+    Board& board = t.board;
+    t.pvLength[ply] = ply;
+    SEARCH_STAT(t.stats.qnodes++);
+    if ((++t.nodes & (NODE_CHECK_INTERVAL - 1)) == 0) checkLimits(t);
+    if (t.stopped) return 0;
+    if (ply >= MAX_PLY - 1) return staticEval(t);
+
+    int bitbaseScore;
+    if (probeBitbase(t, ply, bitbaseScore)) return bitbaseScore;
+
+    // In check every evasion is searched and standing pat is not an option
+    const bool inCheck = board.checkers() != 0;
+    int standPat = 0;
+    int bestScore;
+    if (inCheck) {
+        bestScore = -MATE_SCORE + ply;
+    } else {
+        // The side to move can usually do at least as well as the static score
+        standPat = staticEval(t);
+        bestScore = standPat;
+        if (standPat >= beta) return standPat;
+        alpha = std::max(alpha, standPat);
+    }
+
+    MoveList moves;
+    board.generateMoves(moves, inCheck ? MoveGenType::All : MoveGenType::Captures);
+    scoreMoves(t, moves, Move{-1, -1, -1, -1, 0}, ply);
+
+    for (int i = 0; i < moves.size(); i++) {
+        const Move m = pickMove(moves, i);
+        if (!inCheck) {
+            // Skip captures that lose material in the exchange, and captures that
+            // cannot bring the score back to alpha even when they win the piece
+            int gain = board.see(m);
+            if (gain < 0) continue;
+            if (standPat + gain + DELTA_MARGIN <= alpha) continue;
+        }
+
+        board.makeMove(m);
+        int score = -quiescence(t, ply + 1, -beta, -alpha);
+        board.unmakeMove();
+        if (t.stopped) return 0;
+
+        if (score > bestScore) bestScore = score;
+        if (score > alpha) alpha = score;
+        if (alpha >= beta) break;
+    }
+    return bestScore;
+}
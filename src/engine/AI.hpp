@@ -1,25 +1,228 @@
-#ifndef AI_HPP
-#define AI_HPP
-
-#include "Board.hpp"
-#include <random>
-
-struct Move {
-    int startX, startY;
-    int endX, endY;
-    int score;
-};
-
-class AI {
-public:
-    AI(PieceColor color);
-    Move getBestMove(Board board, int depth);
-
-private:
-    int evaluate(const Board& board);
-    int minimax(Board board, int depth, int alpha, int beta, bool maximizingPlayer);
-    PieceColor aiColor;
-    std::mt19937 rng;
-};
-
-#endif
+#ifndef AI_HPP
+#define AI_HPP
+
+#include "Board.hpp"
+#include "Nnue.hpp"
+#include "PawnTable.hpp"
+#include "PolyglotBook.hpp"
+#include "TranspositionTable.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+const int MAX_PLY = 64;
+// Larger than any material balance. A mate found n plies from the root scores
+// MATE_SCORE - n, so anything beyond MATE_BOUND is a forced mate.
+const int MATE_SCORE = 1000000;
+const int MATE_BOUND = MATE_SCORE - 1000;
+
+// Limits for one search; zero means "no limit". Times are in milliseconds.
+struct SearchLimits {
+    int depth = 0;
+    int moveTime = 0;
+    int whiteTime = 0;
+    int blackTime = 0;
+    int whiteIncrement = 0;
+    int blackIncrement = 0;
+    int movesToGo = 0;
+    std::uint64_t nodes = 0;
+    bool infinite = false;
+    // Search the opponent's time; the clock limits only apply after ponderHit()
+    bool ponder = false;
+};
+
+// Statistics are only collected in builds that define AJEDREZ_SEARCH_STATS (the
+// CMake option of the same name). Otherwise SEARCH_STAT compiles to nothing and
+// the counters stay zero.
+#ifdef AJEDREZ_SEARCH_STATS
+constexpr bool SEARCH_STATS_ENABLED = true;
+#define SEARCH_STAT(statement) statement
+#else
+constexpr bool SEARCH_STATS_ENABLED = false;
+#define SEARCH_STAT(statement) ((void)0)
+#endif
+
+// One completed iteration of the main thread; nodes and time are totals so far.
+struct IterationStats {
+    int depth;
+    std::uint64_t nodes;
+    int timeMs;
+    int score;
+};
+
+// Counters that show how well the move ordering works; a well ordered search
+// gets most of its cutoffs from the first move it tries. Each thread counts
+// into its own copy and the copies are added up when the search ends.
+struct SearchStats {
+    std::uint64_t betaCutoffs = 0;
+    std::uint64_t firstMoveCutoffs = 0;
+    std::uint64_t ttProbes = 0;
+    std::uint64_t ttHits = 0;
+    std::uint64_t ttCutoffs = 0;
+    std::uint64_t qnodes = 0;
+    std::uint64_t bitbaseHits = 0;
+    std::uint64_t pawnProbes = 0;
+    std::uint64_t pawnHits = 0;
+    // Main thread only; add() leaves it alone
+    std::vector<IterationStats> iterations;
+
+    void add(const SearchStats& other) {
+        betaCutoffs += other.betaCutoffs;
+        firstMoveCutoffs += other.firstMoveCutoffs;
+        ttProbes += other.ttProbes;
+        ttHits += other.ttHits;
+        ttCutoffs += other.ttCutoffs;
+        qnodes += other.qnodes;
+        bitbaseHits += other.bitbaseHits;
+        pawnProbes += other.pawnProbes;
+        pawnHits += other.pawnHits;
+    }
+
+    double firstMoveCutoffRate() const { return betaCutoffs ? static_cast<double>(firstMoveCutoffs) / betaCutoffs : 0; }
+    double ttHitRate() const { return ttProbes ? static_cast<double>(ttHits) / ttProbes : 0; }
+    double pawnHitRate() const { return pawnProbes ? static_cast<double>(pawnHits) / pawnProbes : 0; }
+    // Nodes of the last iteration over nodes of the one before it
+    double branchingFactor() const;
+};
+
+struct SearchResult {
+    Move bestMove = {-1, -1, -1, -1, 0};
+    int score = 0;
+    int depth = 0;
+    std::uint64_t nodes = 0;
+    int timeMs = 0;
+    std::vector<Move> pv;
+    SearchStats stats;
+};
+
+// The result as a single-line JSON object, for logging one search per line.
+std::string toJson(const SearchResult& result);
+// s as a quoted JSON string; quotes and backslashes are escaped, control
+// characters dropped
+std::string jsonString(const std::string& s);
+
+class AI {
+public:
+    AI(PieceColor color);
+    ~AI();
+    AI(const AI&) = delete;
+    AI& operator=(const AI&) = delete;
+
+    Move getBestMove(Board board, int depth);
+    // Iterative deepening under the given limits. Returns the result of the
+    // last iteration that finished.
+    SearchResult search(const Board& board, const SearchLimits& limits);
+    // Same search on a worker thread; any search still running is stopped first.
+    // Poll the future with wait_for(0) to keep the caller responsive.
+    std::future<SearchResult> searchAsync(const Board& board, const SearchLimits& limits);
+    // Makes a running search return as soon as possible. Safe from any thread.
+    void stop() { stopRequested = true; }
+    // The opponent played the expected move: a ponder search becomes a normal
+    // timed search, with the clock starting now.
+    void ponderHit();
+    bool isSearching() const { return searching; }
+    // Plays from a Polyglot opening book while the position is in it; searches
+    // (other than infinite analysis) return a book move at once. Returns false if
+    // the file cannot be used.
+    bool loadBook(const std::string& path);
+    void closeBook() { book.close(); }
+    // Both stop and wait for a running search before touching the table
+    void setHashSize(int megabytes);
+    void clearHash();
+    // Number of threads searching the root together (Lazy SMP); at least 1.
+    void setThreads(int count);
+    int getThreads() const { return threadCount; }
+    // Permille of the transposition table in use by recent searches
+    int hashfull() const { return tt.hashfull(); }
+    // Called on the searching thread after each completed iteration, with the
+    // nodes and time so far. Set it while no search is running.
+    void setInfoCallback(std::function<void(const SearchResult&)> callback) { infoCallback = std::move(callback); }
+    // Statistics of the last finished search, including getBestMove calls.
+    // Read it while no search is running.
+    const SearchStats& getLastStats() const { return lastStats; }
+    // Static score of a position in centipawns, from the side of the colour the
+    // AI last searched for (or was created with)
+    int evaluate(const Board& board) const;
+    // Evaluates with the loaded Nnue network instead of the hand-written terms.
+    // Has no effect until a network is loaded.
+    void setUseNnue(bool use);
+    bool usesNnue() const { return useNnue && Nnue::isLoaded(); }
+
+private:
+    // Per-thread search state. Thread 0 is the main thread; the helpers search the
+    // same root at staggered depths and share the transposition table with it.
+    struct SearchThread {
+        int id = 0;
+        Board board;
+        std::mt19937 rng;
+        std::uint64_t nodes = 0;
+        bool stopped = false;
+        SearchResult result;
+
+        // Triangular principal variation table; row ply holds the best line from ply on
+        Move pvTable[MAX_PLY][MAX_PLY];
+        int pvLength[MAX_PLY] = {};
+        std::vector<Move> previousPv;
+        bool followPv = false;
+
+        // Quiet moves that caused a cutoff at each ply, and a from/to score per side
+        // for quiet moves that caused cutoffs anywhere in the tree
+        Move killers[MAX_PLY][2];
+        int history[2][64][64];
+        SearchStats stats;
+        PawnTable pawns;
+    };
+
+    void scoreMoves(const SearchThread& t, MoveList& moves, const Move& hashMove, int ply) const;
+    void updateQuietStats(SearchThread& t, const Move& m, int depth, int ply);
+    // Static score of the thread's board from the side to move's point of view
+    int staticEval(SearchThread& t) const;
+    // Principal variation search: scores are from the side to move's point of view
+    // and every move after the first is tried with a null window first
+    int negamax(SearchThread& t, int depth, int ply, int alpha, int beta, bool nullAllowed);
+    // Captures-only search below the horizon, so leaves are not scored mid-exchange
+    int quiescence(SearchThread& t, int ply, int alpha, int beta);
+    // Exact score for endings covered by the bitbases; false for anything else
+    bool probeBitbase(SearchThread& t, int ply, int& score);
+    SearchResult runSearch(const Board& board, const SearchLimits& limits);
+    void iterativeDeepening(SearchThread& t, const SearchLimits& limits);
+    SearchResult searchRoot(SearchThread& t, int depth, int alpha, int beta);
+    void waitForSearch();
+    void allocateTime(const SearchLimits& limits);
+    void checkLimits(SearchThread& t);
+    int elapsedMs() const;
+    PieceColor aiColor;
+    // The root is itself a bitbase ending, so won lines are searched for the mate
+    // rather than cut off
+    bool rootInBitbase = false;
+    bool useNnue = false;
+    // For evaluate() outside a search; search threads have their own
+    mutable PawnTable pawnTable;
+    std::mt19937 rng;
+    TranspositionTable tt;
+    PolyglotBook book;
+    std::vector<std::unique_ptr<SearchThread>> threads;
+    int threadCount = 1;
+    std::function<void(const SearchResult&)> infoCallback;
+    SearchStats lastStats;
+
+    std::atomic<bool> stopRequested{false};
+    std::atomic<bool> pondering{false};
+    std::atomic<bool> searching{false};
+    std::thread searchThread;
+    std::atomic<std::uint64_t> nodesSearched{0};
+    std::uint64_t nodeLimit = 0;
+    int softTimeMs = 0;
+    int hardTimeMs = 0;
+    // Clock start in steady_clock ticks; atomic because ponderHit resets it
+    std::atomic<std::chrono::steady_clock::rep> startTime{0};
+};
+
+#endif
@@ -0,0 +1,286 @@
+#include "Bitbases.hpp"
+#include "MappedFile.hpp"
+#include <atomic>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace Bitboards;
+
+namespace Bitbases {
+
+namespace {
+
+// Positions are indexed with the stronger side as White:
+// ((sideToMove * 64 + whiteKing) * 64 + blackKing) * 64 + piece
+constexpr int POSITIONS = 2 * 64 * 64 * 64;
+constexpr std::size_t TABLE_BYTES = POSITIONS / 8;
+
+// File layout: the header below followed by TABLE_BYTES of bits, position i at
+// bit (i & 7) of byte i >> 3.
+struct FileHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t positions;
+    std::uint32_t piece;
+};
+constexpr char FILE_MAGIC[4] = {'A', 'J', 'B', 'B'};
+constexpr std::uint32_t FILE_VERSION = 1;
+
+enum Ending { KQK, KRK, KPK, ENDING_COUNT };
+const PieceType endingPiece[ENDING_COUNT] = {PieceType::Queen, PieceType::Rook, PieceType::Pawn};
+const char* endingFile[ENDING_COUNT] = {"kqk.bb", "krk.bb", "kpk.bb"};
+
+struct Table {
+    MappedFile file;
+    std::vector<unsigned char> memory;   // used when the file could not be written
+    const unsigned char* bits = nullptr;
+};
+
+Table tables[ENDING_COUNT];
+std::atomic<bool> loaded{false};
+std::mutex initMutex;
+
+inline int index(int stm, int wk, int bk, int piece) { return ((stm * 64 + wk) * 64 + bk) * 64 + piece; }
+
+inline bool isWin(const unsigned char* bits, int idx) { return (bits[idx >> 3] >> (idx & 7)) & 1; }
+
+enum State : unsigned char { Invalid, Unknown, Draw, Win };
+
+class Generator {
+public:
+    Generator(Ending ending, const unsigned char* queenBits, const unsigned char* rookBits)
+        : ending(ending), piece(endingPiece[ending]), queenBits(queenBits), rookBits(rookBits),
+          states(new std::atomic<unsigned char>[POSITIONS]) {}
+
+    // Iterates to a fixed point: White wins if some move reaches a win, Black
+    // holds if some move reaches a draw. A state only ever moves from Unknown
+    // to a final value, so threads may update the shared array in place and a
+    // stale read only delays a position to the next pass.
+    std::vector<unsigned char> run(int threads) {
+        parallel(threads, [this](int idx) { states[idx].store(classifyInitial(idx), std::memory_order_relaxed); });
+
+        std::atomic<bool> changed{true};
+        while (changed) {
+            changed = false;
+            parallel(threads, [this, &changed](int idx) {
+                if (states[idx].load(std::memory_order_relaxed) != Unknown) return;
+                unsigned char s = classify(idx);
+                if (s != Unknown) {
+                    states[idx].store(s, std::memory_order_relaxed);
+                    changed.store(true, std::memory_order_relaxed);
+                }
+            });
+        }
+
+        // Positions neither side can force anything from are draws.
+        std::vector<unsigned char> bits(TABLE_BYTES, 0);
+        for (int idx = 0; idx < POSITIONS; idx++) {
+            if (states[idx].load(std::memory_order_relaxed) == Win) bits[idx >> 3] |= 1 << (idx & 7);
+        }
+        return bits;
+    }
+
+private:
+    template <typename F>
+    void parallel(int threads, F f) {
+        const int chunk = (POSITIONS + threads - 1) / threads;
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads; t++) {
+            pool.emplace_back([=]() {
+                const int end = std::min(POSITIONS, (t + 1) * chunk);
+                for (int idx = t * chunk; idx < end; idx++) f(idx);
+            });
+        }
+        for (int idx = 0; idx < std::min(POSITIONS, chunk); idx++) f(idx);
+        for (std::thread& t : pool) t.join();
+    }
+
+    Bitboard pieceAttacks(int sq, Bitboard occ) const {
+        switch (piece) {
+        case PieceType::Queen: return queenAttacks(sq, occ);
+        case PieceType::Rook: return rookAttacks(sq, occ);
+        default: return pawnAttacks[0][sq];
+        }
+    }
+
+    unsigned char classifyInitial(int idx) const {
+        const int p = idx & 63, bk = (idx >> 6) & 63, wk = (idx >> 12) & 63, stm = idx >> 18;
+        if (wk == bk || wk == p || bk == p) return Invalid;
+        if (kingAttacks[wk] & squareBB(bk)) return Invalid;
+        if (piece == PieceType::Pawn && (p < 8 || p >= 56)) return Invalid;
+        const Bitboard occ = squareBB(wk) | squareBB(bk) | squareBB(p);
+        const bool blackInCheck = (pieceAttacks(p, occ) & squareBB(bk)) != 0;
+        if (stm == 0 && blackInCheck) return Invalid;
+        if (stm == 1 && !blackMoves(wk, bk, p)) return blackInCheck ? Win : Draw;
+        return Unknown;
+    }
+
+    // Squares the black king can move to, including capturing an undefended piece.
+    Bitboard blackMoves(int wk, int bk, int p) const {
+        const Bitboard attacked = kingAttacks[wk] | pieceAttacks(p, squareBB(wk) | squareBB(p));
+        return kingAttacks[bk] & ~attacked;
+    }
+
+    unsigned char classify(int idx) const {
+        const int p = idx & 63, bk = (idx >> 6) & 63, wk = (idx >> 12) & 63, stm = idx >> 18;
+        return stm == 0 ? classifyWhite(wk, bk, p) : classifyBlack(wk, bk, p);
+    }
+
+    unsigned char classifyBlack(int wk, int bk, int p) const {
+        bool allWin = true;
+        Bitboard targets = blackMoves(wk, bk, p);
+        while (targets) {
+            const int to = popLsb(targets);
+            if (to == p) return Draw;
+            const unsigned char s = states[index(0, wk, to, p)].load(std::memory_order_relaxed);
+            if (s == Draw) return Draw;
+            if (s != Win) allWin = false;
+        }
+        return allWin ? Win : Unknown;
+    }
+
+    unsigned char classifyWhite(int wk, int bk, int p) const {
+        bool allDraw = true;
+        auto child = [&](int k, int sq) {
+            const unsigned char s = states[index(1, k, bk, sq)].load(std::memory_order_relaxed);
+            if (s != Draw) allDraw = false;
+            return s == Win;
+        };
+
+        const Bitboard occ = squareBB(wk) | squareBB(bk) | squareBB(p);
+        Bitboard targets = kingAttacks[wk] & ~kingAttacks[bk] & ~squareBB(p);
+        while (targets) {
+            if (child(popLsb(targets), p)) return Win;
+        }
+
+        if (piece != PieceType::Pawn) {
+            targets = pieceAttacks(p, occ) & ~occ;
+            while (targets) {
+                if (child(wk, popLsb(targets))) return Win;
+            }
+        } else if (!(occ & squareBB(p + 8))) {
+            if (p + 8 >= 56) {
+                // Promote to a queen, or to a rook where a queen would stalemate.
+                const int to = index(1, wk, bk, p + 8);
+                if (isWin(queenBits, to) || isWin(rookBits, to)) return Win;
+            } else {
+                if (child(wk, p + 8)) return Win;
+                if (p < 16 && !(occ & squareBB(p + 16)) && child(wk, p + 16)) return Win;
+            }
+        }
+        return allDraw ? Draw : Unknown;
+    }
+
+    Ending ending;
+    PieceType piece;
+    const unsigned char* queenBits;
+    const unsigned char* rookBits;
+    std::unique_ptr<std::atomic<unsigned char>[]> states;
+};
+
+bool mapTable(Table& table, const std::string& path, Ending ending) {
+    if (!table.file.open(path)) return false;
+    FileHeader header;
+    if (table.file.size() != sizeof(header) + TABLE_BYTES) {
+        table.file.close();
+        return false;
+    }
+    std::memcpy(&header, table.file.data(), sizeof(header));
+    if (std::memcmp(header.magic, FILE_MAGIC, 4) != 0 || header.version != FILE_VERSION ||
+        header.positions != POSITIONS || header.piece != static_cast<std::uint32_t>(endingPiece[ending])) {
+        table.file.close();
+        return false;
+    }
+    table.bits = table.file.data() + sizeof(header);
+    return true;
+}
+
+bool writeTable(const std::string& path, Ending ending, const std::vector<unsigned char>& bits) {
+    FileHeader header;
+    std::memcpy(header.magic, FILE_MAGIC, 4);
+    header.version = FILE_VERSION;
+    header.positions = POSITIONS;
+    header.piece = static_cast<std::uint32_t>(endingPiece[ending]);
+
+    // Write under a temporary name so a reader never maps a half-written file.
+    const std::string temp = path + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(bits.data()), bits.size());
+        if (!out) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp, path, ec);
+    return !ec;
+}
+
+bool loadOrGenerate(Ending ending, const std::string& directory, int threads) {
+    Table& table = tables[ending];
+    const std::string path = (std::filesystem::path(directory) / endingFile[ending]).string();
+    if (mapTable(table, path, ending)) return true;
+
+    std::vector<unsigned char> bits = Generator(ending, tables[KQK].bits, tables[KRK].bits).run(threads);
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (writeTable(path, ending, bits) && mapTable(table, path, ending)) return true;
+
+    table.memory = std::move(bits);
+    table.bits = table.memory.data();
+    return true;
+}
+
+}
+
+bool init(const std::string& directory, int threads) {
+    std::lock_guard<std::mutex> lock(initMutex);
+    if (loaded) return true;
+    Bitboards::init();
+    if (threads < 1) threads = 1;
+
+    // KPK promotions look up the queen and rook tables, so those come first.
+    for (int e = 0; e < ENDING_COUNT; e++) {
+        if (!loadOrGenerate(static_cast<Ending>(e), directory, threads)) return false;
+    }
+    loaded = true;
+    return true;
+}
+
+bool isLoaded() { return loaded; }
+
+bool probe(const Board& board, Result& result) {
+    const Bitboard occ = board.occupancy();
+    const int count = popCount(occ);
+    if (count > 3) return false;
+    if (count == 2) {
+        result = Result::Draw;
+        return true;
+    }
+
+    const int sq = lsb(occ & ~board.pieces(PieceColor::White, PieceType::King) & ~board.pieces(PieceColor::Black, PieceType::King));
+    const Piece extra = board.pieceOn(sq);
+    if (extra.type == PieceType::Knight || extra.type == PieceType::Bishop) {
+        result = Result::Draw;
+        return true;
+    }
+    if (!loaded) return false;
+
+    const Ending ending = extra.type == PieceType::Queen ? KQK : extra.type == PieceType::Rook ? KRK : KPK;
+    const PieceColor strong = extra.color;
+    const int flip = strong == PieceColor::White ? 0 : 56;
+    const int stm = board.getTurn() == strong ? 0 : 1;
+    const int idx = index(stm, board.kingSquare(strong) ^ flip, board.kingSquare(opponent(strong)) ^ flip, sq ^ flip);
+
+    if (!isWin(tables[ending].bits, idx)) result = Result::Draw;
+    else result = stm == 0 ? Result::Win : Result::Loss;
+    return true;
+}
+
+}
@@ -0,0 +1,33 @@
+#ifndef BITBASES_HPP
+#define BITBASES_HPP
+
+#include "Board.hpp"
+#include <string>
+
+// Exact results for king and queen, rook or pawn against a lone king (KQK, KRK,
+// KPK). Each ending is one bit per position: set when the side with the piece
+// wins. The tables are built by retrograde analysis the first time they are
+// needed and saved as files that later runs map straight into memory.
+namespace Bitbases {
+
+enum class Result {
+    Draw,
+    Win,    // for the side to move
+    Loss
+};
+
+// Maps the bitbase files in directory, generating and writing any that are
+// missing or damaged. Generation runs on threads threads. Safe to call more
+// than once; later calls return immediately. Returns false if any table
+// could not be built.
+bool init(const std::string& directory, int threads = 1);
+bool isLoaded();
+
+// Result of a position with at most three pieces. Also answers the trivially
+// drawn endings (bare kings, one minor piece). Returns false for anything else
+// or before init.
+bool probe(const Board& board, Result& result);
+
+}
+
+#endif
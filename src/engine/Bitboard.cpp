@@ -0,0 +1,158 @@
+#include "Bitboard.hpp"
+#include <cassert>
+#include <mutex>
+
+namespace Bitboards {
+
+Bitboard pawnAttacks[2][64];
+Bitboard knightAttacks[64];
+Bitboard kingAttacks[64];
+Bitboard betweenBB[64][64];
+Bitboard lineBB[64][64];
+Magic bishopMagics[64];
+Magic rookMagics[64];
+
+namespace {
+
+Bitboard rookTable[0x19000];   // 102400 entries, the sum of 2^bits over all squares
+Bitboard bishopTable[0x1480];  // 5248 entries
+
+const int rookDirs[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+const int bishopDirs[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+
+bool onBoard(int f, int r) { return f >= 0 && f < 8 && r >= 0 && r < 8; }
+
+// Reference attack generator, only used while building the tables.
+Bitboard slidingAttacks(const int dirs[4][2], int sq, Bitboard occupied) {
+    Bitboard attacks = 0;
+    for (int d = 0; d < 4; d++) {
+        int f = (sq & 7) + dirs[d][0];
+        int r = (sq >> 3) + dirs[d][1];
+        while (onBoard(f, r)) {
+            int s = r * 8 + f;
+            attacks |= squareBB(s);
+            if (occupied & squareBB(s)) break;
+            f += dirs[d][0];
+            r += dirs[d][1];
+        }
+    }
+    return attacks;
+}
+
+Bitboard stepAttacks(int sq, const int steps[][2], int count) {
+    Bitboard attacks = 0;
+    for (int i = 0; i < count; i++) {
+        int f = (sq & 7) + steps[i][0];
+        int r = (sq >> 3) + steps[i][1];
+        if (onBoard(f, r)) attacks |= squareBB(r * 8 + f);
+    }
+    return attacks;
+}
+
+// Found once by a random search for sparse multipliers that map every subset of
+// a square's mask to a distinct slot, or to a slot with the same attacks. PEXT
+// builds do not use them.
+const Bitboard bishopMagicNumbers[64] = {
+    0x10102002004A1420ULL, 0x8020040400584008ULL, 0x10510800811201C8ULL, 0x5204042080000088ULL,
+    0x2204106880000002ULL, 0x1401042004000000ULL, 0x0400880410042004ULL, 0x0028208200A02020ULL,
+    0x1500241990010E00ULL, 0x8001200182020A40ULL, 0x40004101030B0000ULL, 0x8002041042000100ULL,
+    0x4010011041020038ULL, 0x0000010421044000ULL, 0x1500210808020A00ULL, 0x8000088400880520ULL,
+    0x0405004010040100ULL, 0x1005823210040108ULL, 0x2708008102040011ULL, 0x4048200404009100ULL,
+    0x0018104101400024ULL, 0x0003000601190101ULL, 0x8004803108491000ULL, 0x8014241200820800ULL,
+    0x0006E080100C3040ULL, 0x0501044A11041800ULL, 0x9020300008004045ULL, 0x0894080000220040ULL,
+    0x1001010083104000ULL, 0x5004030040900080ULL, 0x000400422C012400ULL, 0x0002128698404812ULL,
+    0x1010108404900440ULL, 0x0928021182084100ULL, 0x2006080409020024ULL, 0x1010202020180080ULL,
+    0xA010008200202200ULL, 0x2098015100019004ULL, 0x0002041440810811ULL, 0x802A02020000B098ULL,
+    0x0009015090004060ULL, 0x4000821082081001ULL, 0x0100210040420800ULL, 0x0800004010488A00ULL,
+    0x2000081104004040ULL, 0x4C8E029015000082ULL, 0x0420340322224842ULL, 0x1298260043400210ULL,
+    0x0000822802400008ULL, 0x00008A0101600000ULL, 0x3040003412080021ULL, 0x3040290220884800ULL,
+    0x4A1500401041004AULL, 0x8010200282020781ULL, 0x0020203142209091ULL, 0x0070300600902110ULL,
+    0x0040808800B62048ULL, 0x0000810400C44420ULL, 0x00080400440C0441ULL, 0x8340080020840411ULL,
+    0x0000000104208200ULL, 0x0000800810D00080ULL, 0x0400530411080200ULL, 0x4040702400932244ULL
+};
+const Bitboard rookMagicNumbers[64] = {
+    0x1080004008801020ULL, 0x0840092002C03000ULL, 0x1900200010400900ULL, 0x0880100008000480ULL,
+    0x4200100420080200ULL, 0x8100020100080400ULL, 0x0200040110886200ULL, 0x0200008040220411ULL,
+    0x0404800084400220ULL, 0x0000401000402000ULL, 0x0086001081220440ULL, 0x0408800800100280ULL,
+    0x000A001201040820ULL, 0x8848800200840080ULL, 0x4001000100040200ULL, 0x0442000102105084ULL,
+    0x9080010020804100ULL, 0x0040404000201009ULL, 0x0000808010002009ULL, 0x2200090021D00100ULL,
+    0x0008008008040080ULL, 0x0004004002010040ULL, 0x0011040008015042ULL, 0x00000A0001768104ULL,
+    0x0000800080204009ULL, 0x2010004140002001ULL, 0x9800200280100080ULL, 0x1000100080080080ULL,
+    0x0442000A00049020ULL, 0x2100040080020080ULL, 0x0800120400900148ULL, 0x0010040A00128541ULL,
+    0x2800804000800030ULL, 0x1010002000400041ULL, 0x4000200011004100ULL, 0x0610008410800800ULL,
+    0x0400802402800800ULL, 0xC100020080800400ULL, 0x0002000802000401ULL, 0x0182085882000401ULL,
+    0x0220204000808000ULL, 0x2860100040024022ULL, 0x0001002004110040ULL, 0x99101042000A0020ULL,
+    0x0004080004008080ULL, 0x0010040002008080ULL, 0x2012004881020004ULL, 0x8300842444820011ULL,
+    0x0088403882010200ULL, 0x0820400080210100ULL, 0x0110910040A00300ULL, 0x0801100280080480ULL,
+    0x0242009008200600ULL, 0x1002000489500200ULL, 0x0040800200010080ULL, 0x0091800041000080ULL,
+    0x0000209300488001ULL, 0x04C1002414824001ULL, 0x020020000B001041ULL, 0x7000100004200901ULL,
+    0x8002002004100802ULL, 0x30010002084C0007ULL, 0x0888221800813004ULL, 0x4000002840840112ULL
+};
+
+void initMagics(Magic magics[64], Bitboard* table, const int dirs[4][2], const Bitboard magicNumbers[64]) {
+    Bitboard* next = table;
+    for (int sq = 0; sq < 64; sq++) {
+        Magic& m = magics[sq];
+        Bitboard edges = ((Rank1 | Rank8) & ~(sq < 8 ? Rank1 : sq >= 56 ? Rank8 : 0)) |
+                         ((FileA | FileH) & ~((sq & 7) == 0 ? FileA : (sq & 7) == 7 ? FileH : 0));
+        m.mask = slidingAttacks(dirs, sq, 0) & ~edges;
+        m.shift = 64 - popCount(m.mask);
+        m.attacks = next;
+        m.magic = magicNumbers[sq];
+
+        // Enumerate every subset of the mask (Carry-Rippler trick). A slider
+        // always attacks some square, so an empty slot has not been written yet.
+        int size = 0;
+        Bitboard b = 0;
+        do {
+            const Bitboard attacks = slidingAttacks(dirs, sq, b);
+            Bitboard& slot = m.attacks[m.index(b)];
+            assert(slot == 0 || slot == attacks);
+            slot = attacks;
+            size++;
+            b = (b - m.mask) & m.mask;
+        } while (b);
+        next += size;
+    }
+}
+
+void initTables() {
+    const int knightSteps[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+    const int kingSteps[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+    const int whitePawnSteps[2][2] = {{-1, 1}, {1, 1}};
+    const int blackPawnSteps[2][2] = {{-1, -1}, {1, -1}};
+
+    for (int sq = 0; sq < 64; sq++) {
+        knightAttacks[sq] = stepAttacks(sq, knightSteps, 8);
+        kingAttacks[sq] = stepAttacks(sq, kingSteps, 8);
+        pawnAttacks[0][sq] = stepAttacks(sq, whitePawnSteps, 2);
+        pawnAttacks[1][sq] = stepAttacks(sq, blackPawnSteps, 2);
+    }
+
+    initMagics(bishopMagics, bishopTable, bishopDirs, bishopMagicNumbers);
+    initMagics(rookMagics, rookTable, rookDirs, rookMagicNumbers);
+
+    for (int a = 0; a < 64; a++) {
+        for (int b = 0; b < 64; b++) {
+            betweenBB[a][b] = lineBB[a][b] = 0;
+            if (a == b) continue;
+            const Bitboard bb = squareBB(b);
+            if (bishopAttacks(a, 0) & bb) {
+                lineBB[a][b] = (bishopAttacks(a, 0) & bishopAttacks(b, 0)) | squareBB(a) | bb;
+                betweenBB[a][b] = bishopAttacks(a, bb) & bishopAttacks(b, squareBB(a));
+            } else if (rookAttacks(a, 0) & bb) {
+                lineBB[a][b] = (rookAttacks(a, 0) & rookAttacks(b, 0)) | squareBB(a) | bb;
+                betweenBB[a][b] = rookAttacks(a, bb) & rookAttacks(b, squareBB(a));
+            }
+        }
+    }
+}
+
+}
+
+void init() {
+    static std::once_flag flag;
+    std::call_once(flag, initTables);
+}
+
+}
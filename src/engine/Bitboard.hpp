@@ -0,0 +1,78 @@
+#ifndef BITBOARD_HPP
+#define BITBOARD_HPP
+
+#include <cstdint>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#define USE_PEXT 1
+#endif
+
+using Bitboard = std::uint64_t;
+
+// Squares are numbered a1 = 0 ... h8 = 63. Board coordinates use x = file (0..7)
+// and y = row from the top of the screen (0 = rank 8, 7 = rank 1).
+inline int makeSquare(int x, int y) { return (7 - y) * 8 + x; }
+inline int squareX(int sq) { return sq & 7; }
+inline int squareY(int sq) { return 7 - (sq >> 3); }
+
+namespace Bitboards {
+
+constexpr Bitboard FileA = 0x0101010101010101ULL;
+constexpr Bitboard FileH = FileA << 7;
+constexpr Bitboard Rank1 = 0xFFULL;
+constexpr Bitboard Rank8 = Rank1 << 56;
+
+struct Magic {
+    Bitboard mask;
+    Bitboard magic;
+    Bitboard* attacks;
+    unsigned shift;
+
+    unsigned index(Bitboard occupied) const {
+#ifdef USE_PEXT
+        return static_cast<unsigned>(_pext_u64(occupied, mask));
+#else
+        return static_cast<unsigned>(((occupied & mask) * magic) >> shift);
+#endif
+    }
+};
+
+extern Bitboard pawnAttacks[2][64];
+extern Bitboard knightAttacks[64];
+extern Bitboard kingAttacks[64];
+extern Bitboard betweenBB[64][64];
+extern Bitboard lineBB[64][64];
+extern Magic bishopMagics[64];
+extern Magic rookMagics[64];
+
+// Builds the attack tables. Safe to call more than once; only the first call does work.
+void init();
+
+inline Bitboard squareBB(int sq) { return 1ULL << sq; }
+inline int popCount(Bitboard b) { return __builtin_popcountll(b); }
+inline int lsb(Bitboard b) { return __builtin_ctzll(b); }
+inline int popLsb(Bitboard& b) {
+    int sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+inline bool moreThanOne(Bitboard b) { return (b & (b - 1)) != 0; }
+
+inline Bitboard bishopAttacks(int sq, Bitboard occupied) {
+    const Magic& m = bishopMagics[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard rookAttacks(int sq, Bitboard occupied) {
+    const Magic& m = rookMagics[sq];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard queenAttacks(int sq, Bitboard occupied) {
+    return bishopAttacks(sq, occupied) | rookAttacks(sq, occupied);
+}
+
+}
+
+#endif
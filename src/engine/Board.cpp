@@ -1,274 +1,523 @@
-#include "Board.hpp"
-#include <cmath>
-
-Board::Board() {
-    reset();
-}
-
-void Board::reset() {
-    turn = PieceColor::White;
-    for (int i = 0; i < 8; i++) {
-        for (int j = 0; j < 8; j++) {
-            squares[i][j] = {PieceType::None, PieceColor::None};
-        }
-    }
-
-    // Set up pawns
-    for (int i = 0; i < 8; i++) {
-        squares[i][1] = {PieceType::Pawn, PieceColor::Black};
-        squares[i][6] = {PieceType::Pawn, PieceColor::White};
-    }
-
-    // Set up back rows
-    PieceColor colors[2] = {PieceColor::Black, PieceColor::White};
-    int rows[2] = {0, 7};
-    for (int k = 0; k < 2; k++) {
-        int r = rows[k];
-        PieceColor c = colors[k];
-        squares[0][r] = squares[7][r] = {PieceType::Rook, c};
-        squares[1][r] = squares[6][r] = {PieceType::Knight, c};
-        squares[2][r] = squares[5][r] = {PieceType::Bishop, c};
-        squares[3][r] = {PieceType::Queen, c};
-        squares[4][r] = {PieceType::King, c};
-    }
-
-    whiteKingMoved = blackKingMoved = false;
-    whiteRookAMoved = whiteRookHMoved = false;
-    blackRookAMoved = blackRookHMoved = false;
-}
-
-Piece Board::getPiece(int x, int y) const {
-    if (x < 0 || x >= 8 || y < 0 || y >= 8) return {PieceType::None, PieceColor::None};
-    return squares[x][y];
-}
-
-bool Board::isLegalMove(int startX, int startY, int endX, int endY) const {
-    if (startX < 0 || startX >= 8 || startY < 0 || startY >= 8) return false;
-    if (endX < 0 || endX >= 8 || endY < 0 || endY >= 8) return false;
-    
-    Piece startPiece = squares[startX][startY];
-    if (startPiece.color != turn) return false;
-    
-    Piece endPiece = squares[endX][endY];
-    if (endPiece.color == turn) return false;
-
-    bool basicMoveLegal = false;
-    switch (startPiece.type) {
-        case PieceType::Pawn: basicMoveLegal = isValidPawnMove(startX, startY, endX, endY); break;
-        case PieceType::Knight: basicMoveLegal = isValidKnightMove(startX, startY, endX, endY); break;
-        case PieceType::Bishop: basicMoveLegal = isValidBishopMove(startX, startY, endX, endY); break;
-        case PieceType::Rook: basicMoveLegal = isValidRookMove(startX, startY, endX, endY); break;
-        case PieceType::Queen: basicMoveLegal = isValidQueenMove(startX, startY, endX, endY); break;
-        case PieceType::King: basicMoveLegal = isValidKingMove(startX, startY, endX, endY); break;
-        default: basicMoveLegal = false;
-    }
-
-    if (!basicMoveLegal) return false;
-
-    // Simulate move to check for king safety (except for castling which has its own checks)
-    if (startPiece.type == PieceType::King && std::abs(endX - startX) == 2) {
-        return true; // isValidKingMove already handled check safety for castling
-    }
-
-    Board tempBoard = *this;
-    // Perform standard move on temp board (ignore castling rook move here as we already validated it)
-    tempBoard.squares[endX][endY] = tempBoard.squares[startX][startY];
-    tempBoard.squares[startX][startY] = {PieceType::None, PieceColor::None};
-    
-    return !tempBoard.isInCheck(startPiece.color);
-}
-
-bool Board::movePiece(int startX, int startY, int endX, int endY) {
-    if (isLegalMove(startX, startY, endX, endY)) {
-        Piece p = squares[startX][startY];
-        
-        // Handle castling rook move
-        if (p.type == PieceType::King && std::abs(endX - startX) == 2) {
-            int rookStartY = startY;
-            int rookStartX = (endX > startX) ? 7 : 0;
-            int rookEndX = (endX > startX) ? 5 : 3;
-            squares[rookEndX][rookStartY] = squares[rookStartX][rookStartY];
-            squares[rookStartX][rookStartY] = {PieceType::None, PieceColor::None};
-        }
-
-        // Update movement flags
-        if (p.type == PieceType::King) {
-            if (p.color == PieceColor::White) whiteKingMoved = true;
-            else blackKingMoved = true;
-        }
-        if (p.type == PieceType::Rook) {
-            if (startX == 0 && startY == 7) whiteRookAMoved = true;
-            if (startX == 7 && startY == 7) whiteRookHMoved = true;
-            if (startX == 0 && startY == 0) blackRookAMoved = true;
-            if (startX == 7 && startY == 0) blackRookHMoved = true;
-        }
-
-        squares[endX][endY] = squares[startX][startY];
-        squares[startX][startY] = {PieceType::None, PieceColor::None};
-        turn = (turn == PieceColor::White) ? PieceColor::Black : PieceColor::White;
-        return true;
-    }
-    return false;
-}
-
-bool Board::isValidPawnMove(int startX, int startY, int endX, int endY) const {
-    int dir = (squares[startX][startY].color == PieceColor::White) ? -1 : 1;
-    int dx = endX - startX;
-    int dy = endY - startY;
-
-    if (dx == 0) {
-        if (dy == dir && squares[endX][endY].type == PieceType::None) return true;
-        if (dy == 2 * dir && ((startY == 1 && dir == 1) || (startY == 6 && dir == -1)) && 
-            squares[endX][endY].type == PieceType::None && squares[startX][startY + dir].type == PieceType::None) return true;
-    } else if (std::abs(dx) == 1 && dy == dir) {
-        if (squares[endX][endY].type != PieceType::None && squares[endX][endY].color != squares[startX][startY].color) return true;
-    }
-    return false;
-}
-
-bool Board::isValidKnightMove(int startX, int startY, int endX, int endY) const {
-    int dx = std::abs(endX - startX);
-    int dy = std::abs(endY - startY);
-    return (dx == 1 && dy == 2) || (dx == 2 && dy == 1);
-}
-
-bool Board::isValidBishopMove(int startX, int startY, int endX, int endY) const {
-    if (std::abs(endX - startX) != std::abs(endY - startY)) return false;
-    return isPathClear(startX, startY, endX, endY);
-}
-
-bool Board::isValidRookMove(int startX, int startY, int endX, int endY) const {
-    if (startX != endX && startY != endY) return false;
-    return isPathClear(startX, startY, endX, endY);
-}
-
-bool Board::isValidQueenMove(int startX, int startY, int endX, int endY) const {
-    if (startX != endX && startY != endY && std::abs(endX - startX) != std::abs(endY - startY)) return false;
-    return isPathClear(startX, startY, endX, endY);
-}
-
-bool Board::isValidKingMove(int startX, int startY, int endX, int endY) const {
-    int dx = std::abs(endX - startX);
-    int dy = std::abs(endY - startY);
-    
-    if (dx <= 1 && dy <= 1) return true;
-
-    // Castling
-    if (dy == 0 && dx == 2) {
-        PieceColor color = squares[startX][startY].color;
-        bool kingMoved = (color == PieceColor::White) ? whiteKingMoved : blackKingMoved;
-        if (kingMoved) return false;
-        if (isInCheck(color)) return false;
-
-        if (endX > startX) { // King-side
-            bool rookMoved = (color == PieceColor::White) ? whiteRookHMoved : blackRookHMoved;
-            if (rookMoved) return false;
-            if (!isPathClear(startX, startY, 7, startY)) return false;
-            if (isSquareAttacked(startX + 1, startY, (color == PieceColor::White ? PieceColor::Black : PieceColor::White))) return false;
-        } else { // Queen-side
-            bool rookMoved = (color == PieceColor::White) ? whiteRookAMoved : blackRookAMoved;
-            if (rookMoved) return false;
-            if (!isPathClear(startX, startY, 0, startY)) return false;
-            if (isSquareAttacked(startX - 1, startY, (color == PieceColor::White ? PieceColor::Black : PieceColor::White))) return false;
-        }
-        return true;
-    }
-
-    return false;
-}
-
-bool Board::isSquareAttacked(int x, int y, PieceColor attackerColor) const {
-    for (int i = 0; i < 8; i++) {
-        for (int j = 0; j < 8; j++) {
-            Piece p = squares[i][j];
-            if (p.color == attackerColor) {
-                // Simplified check: we use the move validation logic
-                // Temporarily swap turn to use isLegalMove logic for checking attacks
-                Board* mutableThis = const_cast<Board*>(this);
-                PieceColor originalTurn = mutableThis->turn;
-                mutableThis->turn = attackerColor;
-                bool canReach = false;
-                
-                // For pawns, we only care about diagonals
-                if (p.type == PieceType::Pawn) {
-                    int dir = (attackerColor == PieceColor::White) ? -1 : 1;
-                    if (std::abs(i - x) == 1 && (y - j) == dir) canReach = true;
-                } else {
-                    // Check other pieces. Note: we don't call isLegalMove directly to avoid recursion
-                    // we'll implement a simple attack version
-                    int dx = std::abs(x - i);
-                    int dy = std::abs(y - j);
-                    switch (p.type) {
-                        case PieceType::Knight: if ((dx == 1 && dy == 2) || (dx == 2 && dy == 1)) canReach = true; break;
-                        case PieceType::Bishop: if (dx == dy && isPathClear(i, j, x, y)) canReach = true; break;
-                        case PieceType::Rook: if ((i == x || j == y) && isPathClear(i, j, x, y)) canReach = true; break;
-                        case PieceType::Queen: if ((dx == dy || i == x || j == y) && isPathClear(i, j, x, y)) canReach = true; break;
-                        case PieceType::King: if (dx <= 1 && dy <= 1) canReach = true; break;
-                        default: break;
-                    }
-                }
-
-                mutableThis->turn = originalTurn;
-                if (canReach) return true;
-            }
-        }
-    }
-    return false;
-}
-
-bool Board::isInCheck(PieceColor color) const {
-    int kx = -1, ky = -1;
-    for (int i = 0; i < 8; i++) {
-        for (int j = 0; j < 8; j++) {
-            if (squares[i][j].type == PieceType::King && squares[i][j].color == color) {
-                kx = i; ky = j; break;
-            }
-        }
-    }
-    if (kx == -1) return false;
-    return isSquareAttacked(kx, ky, (color == PieceColor::White ? PieceColor::Black : PieceColor::White));
-}
-
-bool Board::hasLegalMoves(PieceColor color) const {
-    // Save current turn state
-    PieceColor originalTurn = turn;
-    Board* mutableThis = const_cast<Board*>(this);
-    mutableThis->turn = color;
-
-    for (int sx = 0; sx < 8; sx++) {
-        for (int sy = 0; sy < 8; sy++) {
-            if (squares[sx][sy].color == color) {
-                for (int ex = 0; ex < 8; ex++) {
-                    for (int ey = 0; ey < 8; ey++) {
-                        if (isLegalMove(sx, sy, ex, ey)) {
-                            mutableThis->turn = originalTurn;
-                            return true;
-                        }
-                    }
-                }
-            }
-        }
-    }
-    mutableThis->turn = originalTurn;
-    return false;
-}
-
-bool Board::isCheckmate(PieceColor color) const {
-    return isInCheck(color) && !hasLegalMoves(color);
-}
-
-bool Board::isStalemate(PieceColor color) const {
-    return !isInCheck(color) && !hasLegalMoves(color);
-}
-bool Board::isPathClear(int startX, int startY, int endX, int endY) const {
-    int dx = (endX > startX) ? 1 : (endX < startX ? -1 : 0);
-    int dy = (endY > startY) ? 1 : (endY < startY ? -1 : 0);
-    int x = startX + dx;
-    int y = startY + dy;
-    while (x != endX || y != endY) {
-        if (squares[x][y].type != PieceType::None) return false;
-        x += dx;
-        y += dy;
-    }
-    return true;
-}
+#include "Board.hpp"
+#include "Zobrist.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <sstream>
+
+namespace {
+
+// Rights that survive a move touching each square: moving the king or a rook,
+// or capturing a rook on its corner, clears the matching rights.
+struct CastlingMasks {
+    std::uint8_t mask[64];
+
+    constexpr CastlingMasks() : mask() {
+        for (int sq = 0; sq < 64; sq++) mask[sq] = AllCastling;
+        mask[0] = AllCastling & ~WhiteQueenSide;
+        mask[7] = AllCastling & ~WhiteKingSide;
+        mask[4] = AllCastling & ~(WhiteKingSide | WhiteQueenSide);
+        mask[56] = AllCastling & ~BlackQueenSide;
+        mask[63] = AllCastling & ~BlackKingSide;
+        mask[60] = AllCastling & ~(BlackKingSide | BlackQueenSide);
+    }
+};
+
+constexpr CastlingMasks castlingMasks;
+
+}
+
+Board::Board() {
+    Bitboards::init();
+    Zobrist::init();
+    Psqt::init();
+    history.reserve(256);
+    reset();
+}
+
+void Board::clear() {
+    turn = PieceColor::White;
+    epSquare = -1;
+    halfmoveClock = 0;
+    fullmoveNumber = 1;
+    castlingRights = 0;
+    for (int c = 0; c < 2; c++) {
+        colorBB[c] = 0;
+        for (int t = 0; t < 6; t++) pieceBB[c][t] = 0;
+    }
+    occupied = 0;
+    key = 0;
+    pawnKey = 0;
+    kingSq[0] = kingSq[1] = -1;
+    checkersBB = pinnedBB = 0;
+    psqtScore[0] = psqtScore[1] = Psqt::Score();
+    phase = 0;
+    accumulator.network = 0;
+    for (int sq = 0; sq < 64; sq++) mailbox[sq] = {PieceType::None, PieceColor::None};
+    history.clear();
+}
+
+void Board::reset() {
+    clear();
+
+    // Set up pawns
+    for (int i = 0; i < 8; i++) {
+        putPiece(makeSquare(i, 1), {PieceType::Pawn, PieceColor::Black});
+        putPiece(makeSquare(i, 6), {PieceType::Pawn, PieceColor::White});
+    }
+
+    // Set up back rows
+    PieceColor colors[2] = {PieceColor::Black, PieceColor::White};
+    int rows[2] = {0, 7};
+    PieceType backRow[8] = {PieceType::Rook, PieceType::Knight, PieceType::Bishop, PieceType::Queen,
+                            PieceType::King, PieceType::Bishop, PieceType::Knight, PieceType::Rook};
+    for (int k = 0; k < 2; k++) {
+        for (int i = 0; i < 8; i++) {
+            putPiece(makeSquare(i, rows[k]), {backRow[i], colors[k]});
+        }
+    }
+
+    castlingRights = AllCastling;
+    key ^= Zobrist::castling[castlingRights];
+    updateCheckInfo();
+}
+
+bool Board::fromFEN(const std::string& fen) {
+    std::istringstream in(fen);
+    std::string placement, side, castling = "-", ep = "-";
+    int halfmoves = 0, fullmoves = 1;
+    if (!(in >> placement >> side)) return false;
+    in >> castling >> ep;
+    if (in >> halfmoves) {
+        if (halfmoves < 0 || !(in >> fullmoves) || fullmoves < 1) return false;
+    }
+
+    Board parsed;
+    parsed.clear();
+
+    int x = 0, y = 0;
+    for (char ch : placement) {
+        if (ch == '/') {
+            if (x != 8) return false;
+            x = 0;
+            y++;
+        } else if (ch >= '1' && ch <= '8') {
+            x += ch - '0';
+        } else {
+            static const std::string letters = "pnbrqk";
+            std::size_t t = letters.find(static_cast<char>(std::tolower(ch)));
+            if (t == std::string::npos || x > 7 || y > 7) return false;
+            PieceColor color = std::isupper(static_cast<unsigned char>(ch)) ? PieceColor::White : PieceColor::Black;
+            parsed.putPiece(makeSquare(x, y), {static_cast<PieceType>(t + 1), color});
+            x++;
+        }
+        if (x > 8) return false;
+    }
+    if (y != 7 || x != 8) return false;
+    if (Bitboards::popCount(parsed.pieces(PieceColor::White, PieceType::King)) != 1 ||
+        Bitboards::popCount(parsed.pieces(PieceColor::Black, PieceType::King)) != 1) return false;
+
+    if (side == "w") parsed.turn = PieceColor::White;
+    else if (side == "b") parsed.turn = PieceColor::Black;
+    else return false;
+    if (parsed.turn == PieceColor::Black) parsed.key ^= Zobrist::blackToMove;
+
+    if (castling != "-") {
+        for (char ch : castling) {
+            switch (ch) {
+                case 'K': parsed.castlingRights |= WhiteKingSide; break;
+                case 'Q': parsed.castlingRights |= WhiteQueenSide; break;
+                case 'k': parsed.castlingRights |= BlackKingSide; break;
+                case 'q': parsed.castlingRights |= BlackQueenSide; break;
+                default: return false;
+            }
+        }
+    }
+    parsed.key ^= Zobrist::castling[parsed.castlingRights];
+
+    if (ep != "-") {
+        if (ep.size() != 2 || ep[0] < 'a' || ep[0] > 'h' || (ep[1] != '3' && ep[1] != '6')) return false;
+        // Kept only when a pawn can take there, as after a double push
+        const int square = (ep[1] - '1') * 8 + (ep[0] - 'a');
+        if (Bitboards::pawnAttacks[colorIndex(opponent(parsed.turn))][square] & parsed.pieces(parsed.turn, PieceType::Pawn)) {
+            parsed.epSquare = square;
+            parsed.key ^= Zobrist::enPassantFile[square & 7];
+        }
+    }
+
+    parsed.halfmoveClock = halfmoves;
+    parsed.fullmoveNumber = fullmoves;
+    parsed.updateCheckInfo();
+    *this = parsed;
+    return true;
+}
+
+std::string Board::toFEN() const {
+    std::string fen;
+    for (int y = 0; y < 8; y++) {
+        int empty = 0;
+        for (int x = 0; x < 8; x++) {
+            Piece p = mailbox[makeSquare(x, y)];
+            if (p.type == PieceType::None) {
+                empty++;
+                continue;
+            }
+            if (empty) fen += static_cast<char>('0' + empty);
+            empty = 0;
+            char letter = "pnbrqk"[typeIndex(p.type)];
+            fen += p.color == PieceColor::White ? static_cast<char>(std::toupper(letter)) : letter;
+        }
+        if (empty) fen += static_cast<char>('0' + empty);
+        if (y < 7) fen += '/';
+    }
+
+    fen += turn == PieceColor::White ? " w " : " b ";
+    if (castlingRights & WhiteKingSide) fen += 'K';
+    if (castlingRights & WhiteQueenSide) fen += 'Q';
+    if (castlingRights & BlackKingSide) fen += 'k';
+    if (castlingRights & BlackQueenSide) fen += 'q';
+    if (!castlingRights) fen += '-';
+    fen += ' ';
+    if (epSquare >= 0) {
+        fen += static_cast<char>('a' + (epSquare & 7));
+        fen += static_cast<char>('1' + (epSquare >> 3));
+    } else {
+        fen += '-';
+    }
+    fen += " " + std::to_string(halfmoveClock) + " " + std::to_string(fullmoveNumber);
+    return fen;
+}
+
+void Board::putPiece(int sq, Piece p) {
+    Bitboard bb = Bitboards::squareBB(sq);
+    pieceBB[colorIndex(p.color)][typeIndex(p.type)] |= bb;
+    colorBB[colorIndex(p.color)] |= bb;
+    occupied |= bb;
+    mailbox[sq] = p;
+    if (p.type == PieceType::King) kingSq[colorIndex(p.color)] = sq;
+    key ^= Zobrist::pieceSquare[colorIndex(p.color)][typeIndex(p.type)][sq];
+    if (p.type == PieceType::Pawn) pawnKey ^= Zobrist::pieceSquare[colorIndex(p.color)][0][sq];
+    psqtScore[colorIndex(p.color)] += Psqt::table[colorIndex(p.color)][typeIndex(p.type)][sq];
+    phase += Psqt::phaseWeight[typeIndex(p.type)];
+    if (Nnue::isCurrent(accumulator)) Nnue::addPiece(accumulator, sq, p);
+}
+
+void Board::removePiece(int sq) {
+    Piece p = mailbox[sq];
+    if (p.type == PieceType::None) return;
+    Bitboard bb = Bitboards::squareBB(sq);
+    pieceBB[colorIndex(p.color)][typeIndex(p.type)] ^= bb;
+    colorBB[colorIndex(p.color)] ^= bb;
+    occupied ^= bb;
+    mailbox[sq] = {PieceType::None, PieceColor::None};
+    key ^= Zobrist::pieceSquare[colorIndex(p.color)][typeIndex(p.type)][sq];
+    if (p.type == PieceType::Pawn) pawnKey ^= Zobrist::pieceSquare[colorIndex(p.color)][0][sq];
+    psqtScore[colorIndex(p.color)] -= Psqt::table[colorIndex(p.color)][typeIndex(p.type)][sq];
+    phase -= Psqt::phaseWeight[typeIndex(p.type)];
+    if (Nnue::isCurrent(accumulator)) Nnue::removePiece(accumulator, sq, p);
+}
+
+const Nnue::Accumulator& Board::nnueAccumulator() const {
+    if (!Nnue::isCurrent(accumulator)) Nnue::refresh(accumulator, *this);
+    return accumulator;
+}
+
+Piece Board::getPiece(int x, int y) const {
+    if (x < 0 || x >= 8 || y < 0 || y >= 8) return {PieceType::None, PieceColor::None};
+    return mailbox[makeSquare(x, y)];
+}
+
+bool Board::isLegalMove(int startX, int startY, int endX, int endY) const {
+    if (startX < 0 || startX >= 8 || startY < 0 || startY >= 8) return false;
+    if (endX < 0 || endX >= 8 || endY < 0 || endY >= 8) return false;
+    if (mailbox[makeSquare(startX, startY)].color != turn) return false;
+
+    MoveList moves;
+    generateMoves(moves);
+    Move wanted = {startX, startY, endX, endY, 0};
+    for (const Move& m : moves) {
+        if (m.sameSquares(wanted)) return true;
+    }
+    return false;
+}
+
+bool Board::movePiece(int startX, int startY, int endX, int endY, PieceType promotion) {
+    if (!isLegalMove(startX, startY, endX, endY)) return false;
+
+    Move m = {startX, startY, endX, endY, 0};
+    Piece p = mailbox[makeSquare(startX, startY)];
+    if (p.type == PieceType::Pawn && (endY == 0 || endY == 7)) {
+        m.promotion = (promotion == PieceType::None || promotion == PieceType::Pawn || promotion == PieceType::King)
+                          ? PieceType::Queen : promotion;
+    }
+    makeMove(m);
+    return true;
+}
+
+void Board::makeMove(const Move& m) {
+    const int from = makeSquare(m.startX, m.startY);
+    const int to = makeSquare(m.endX, m.endY);
+    const Piece p = mailbox[from];
+    Piece captured = mailbox[to];
+
+    history.push_back({key, static_cast<std::uint8_t>(from), static_cast<std::uint8_t>(to), m.promotion,
+                       captured, castlingRights, static_cast<std::int8_t>(epSquare),
+                       static_cast<std::uint16_t>(halfmoveClock)});
+    const int ep = epSquare;
+    if (ep >= 0) key ^= Zobrist::enPassantFile[ep & 7];
+    epSquare = -1;
+
+    // Handle castling rook move
+    if (p.type == PieceType::King && std::abs(to - from) == 2) {
+        int rookFrom = (to > from) ? from + 3 : from - 4;
+        int rookTo = (to > from) ? from + 1 : from - 1;
+        Piece rook = mailbox[rookFrom];
+        removePiece(rookFrom);
+        putPiece(rookTo, rook);
+    }
+
+    if (p.type == PieceType::Pawn) {
+        // En passant removes the pawn that just passed the target square
+        if (to == ep) removePiece(p.color == PieceColor::White ? to - 8 : to + 8);
+        // The square only counts, in the key too, when an enemy pawn can take
+        // there; otherwise transpositions through a double push would differ
+        const int passed = (from + to) / 2;
+        if (std::abs(to - from) == 16 &&
+            (Bitboards::pawnAttacks[colorIndex(p.color)][passed] & pieces(opponent(p.color), PieceType::Pawn))) {
+            epSquare = passed;
+            key ^= Zobrist::enPassantFile[passed & 7];
+        }
+    }
+
+    key ^= Zobrist::castling[castlingRights];
+    castlingRights &= castlingMasks.mask[from] & castlingMasks.mask[to];
+    key ^= Zobrist::castling[castlingRights];
+
+    if (captured.type != PieceType::None) removePiece(to);
+    removePiece(from);
+    putPiece(to, m.promotion != PieceType::None ? Piece{m.promotion, p.color} : p);
+    halfmoveClock = (p.type == PieceType::Pawn || captured.type != PieceType::None) ? 0 : halfmoveClock + 1;
+    if (turn == PieceColor::Black) fullmoveNumber++;
+    turn = opponent(turn);
+    key ^= Zobrist::blackToMove;
+    updateCheckInfo();
+}
+
+void Board::unmakeMove() {
+    const UndoInfo u = history.back();
+    history.pop_back();
+
+    turn = opponent(turn);
+    castlingRights = u.castlingRights;
+    epSquare = u.epSquare;
+    halfmoveClock = u.halfmoveClock;
+    if (turn == PieceColor::Black) fullmoveNumber--;
+
+    Piece p = mailbox[u.to];
+    removePiece(u.to);
+    if (u.promotion != PieceType::None) p.type = PieceType::Pawn;
+    putPiece(u.from, p);
+    if (u.captured.type != PieceType::None) putPiece(u.to, u.captured);
+
+    if (p.type == PieceType::King && std::abs(u.to - u.from) == 2) {
+        int rookFrom = (u.to > u.from) ? u.from + 3 : u.from - 4;
+        int rookTo = (u.to > u.from) ? u.from + 1 : u.from - 1;
+        Piece rook = mailbox[rookTo];
+        removePiece(rookTo);
+        putPiece(rookFrom, rook);
+    } else if (p.type == PieceType::Pawn && u.to == epSquare) {
+        putPiece(p.color == PieceColor::White ? u.to - 8 : u.to + 8, {PieceType::Pawn, opponent(p.color)});
+    }
+    key = u.key;
+    updateCheckInfo();
+}
+
+void Board::makeNullMove() {
+    history.push_back({key, 0, 0, PieceType::None, Piece{}, castlingRights, static_cast<std::int8_t>(epSquare),
+                       static_cast<std::uint16_t>(halfmoveClock)});
+    if (epSquare >= 0) key ^= Zobrist::enPassantFile[epSquare & 7];
+    epSquare = -1;
+    halfmoveClock++;
+    turn = opponent(turn);
+    key ^= Zobrist::blackToMove;
+    updateCheckInfo();
+}
+
+void Board::unmakeNullMove() {
+    const UndoInfo u = history.back();
+    history.pop_back();
+    turn = opponent(turn);
+    epSquare = u.epSquare;
+    halfmoveClock = u.halfmoveClock;
+    key = u.key;
+    updateCheckInfo();
+}
+
+void Board::updateCheckInfo() {
+    using namespace Bitboards;
+    checkersBB = pinnedBB = 0;
+    const int us = colorIndex(turn);
+    const int ksq = kingSq[us];
+    if (ksq < 0) return;
+    const Bitboard* them = pieceBB[us ^ 1];
+
+    checkersBB = attackersTo(ksq, occupied) & colorBB[us ^ 1];
+
+    // Cast rays out from the king through empty boards; an enemy slider on a ray
+    // with exactly one piece in between pins that piece if it is ours
+    Bitboard snipers = (rookAttacks(ksq, 0) & (them[3] | them[4])) |
+                       (bishopAttacks(ksq, 0) & (them[2] | them[4]));
+    while (snipers) {
+        Bitboard blockers = betweenBB[ksq][popLsb(snipers)] & occupied;
+        if (blockers && !moreThanOne(blockers)) pinnedBB |= blockers & colorBB[us];
+    }
+}
+
+bool Board::isLegal(const Move& m) const {
+    using namespace Bitboards;
+    const int from = makeSquare(m.startX, m.startY);
+    const int to = makeSquare(m.endX, m.endY);
+    const int us = colorIndex(turn);
+    const Piece p = mailbox[from];
+
+    if (p.type == PieceType::King) {
+        // Castling moves are only generated when the king's path is safe
+        if (std::abs(to - from) == 2) return true;
+        // The king itself must not block a slider's ray to the square it steps to
+        return !(attackersTo(to, occupied ^ squareBB(from)) & colorBB[us ^ 1]);
+    }
+
+    const int ksq = kingSq[us];
+    if (p.type == PieceType::Pawn && to == epSquare) {
+        // Two pawns leave the same rank at once, which pins cannot describe; test the rays directly
+        const Bitboard captured = squareBB(turn == PieceColor::White ? to - 8 : to + 8);
+        const Bitboard occ = (occupied ^ squareBB(from) ^ captured) | squareBB(to);
+        const Bitboard* them = pieceBB[us ^ 1];
+        return !((pawnAttacks[us][ksq] & them[0] & ~captured) ||
+                 (knightAttacks[ksq] & them[1]) ||
+                 (bishopAttacks(ksq, occ) & (them[2] | them[4])) ||
+                 (rookAttacks(ksq, occ) & (them[3] | them[4])));
+    }
+
+    if (checkersBB) {
+        // Against a double check only the king can move; a single check must be
+        // captured or blocked
+        if (moreThanOne(checkersBB)) return false;
+        if (!((betweenBB[ksq][lsb(checkersBB)] | checkersBB) & squareBB(to))) return false;
+    }
+
+    // A pinned piece may only move along the line through its king
+    return !(pinnedBB & squareBB(from)) || (lineBB[from][ksq] & squareBB(to));
+}
+
+Bitboard Board::attackersTo(int sq, Bitboard occ) const {
+    using namespace Bitboards;
+    const Bitboard bishopsQueens = pieceBB[0][2] | pieceBB[1][2] | pieceBB[0][4] | pieceBB[1][4];
+    const Bitboard rooksQueens = pieceBB[0][3] | pieceBB[1][3] | pieceBB[0][4] | pieceBB[1][4];
+    return (pawnAttacks[1][sq] & pieceBB[0][0])
+         | (pawnAttacks[0][sq] & pieceBB[1][0])
+         | (knightAttacks[sq] & (pieceBB[0][1] | pieceBB[1][1]))
+         | (kingAttacks[sq] & (pieceBB[0][5] | pieceBB[1][5]))
+         | (bishopAttacks(sq, occ) & bishopsQueens)
+         | (rookAttacks(sq, occ) & rooksQueens);
+}
+
+int Board::see(const Move& m) const {
+    using namespace Bitboards;
+    const int from = makeSquare(m.startX, m.startY);
+    const int to = makeSquare(m.endX, m.endY);
+    const Piece mover = mailbox[from];
+
+    Bitboard occ = occupied ^ squareBB(from);
+    int gain[32];
+    int d = 0;
+    if (mover.type == PieceType::Pawn && to == epSquare) {
+        occ ^= squareBB(turn == PieceColor::White ? to - 8 : to + 8);
+        gain[0] = SEE_VALUE[0];
+    } else {
+        gain[0] = mailbox[to].type != PieceType::None ? SEE_VALUE[typeIndex(mailbox[to].type)] : 0;
+    }
+    int onSquare = SEE_VALUE[typeIndex(mover.type)];
+    if (m.promotion != PieceType::None) {
+        gain[0] += SEE_VALUE[typeIndex(m.promotion)] - SEE_VALUE[0];
+        onSquare = SEE_VALUE[typeIndex(m.promotion)];
+    }
+
+    const Bitboard bishopsQueens = pieceBB[0][2] | pieceBB[1][2] | pieceBB[0][4] | pieceBB[1][4];
+    const Bitboard rooksQueens = pieceBB[0][3] | pieceBB[1][3] | pieceBB[0][4] | pieceBB[1][4];
+    Bitboard attackers = attackersTo(to, occ) & occ;
+    int side = colorIndex(opponent(turn));
+
+    while (d < 31) {
+        Bitboard ours = attackers & colorBB[side];
+        if (!ours) break;
+        int t = 0;
+        while (!(ours & pieceBB[side][t])) t++;
+        // The king can only recapture when nothing defends the square any more
+        if (t == 5 && (attackers & colorBB[side ^ 1])) break;
+
+        d++;
+        gain[d] = onSquare - gain[d - 1];
+        // Neither side can do better by continuing
+        if (std::max(-gain[d - 1], gain[d]) < 0) break;
+
+        // Removing the capturer may uncover a slider behind it
+        occ ^= squareBB(lsb(ours & pieceBB[side][t]));
+        attackers |= (bishopAttacks(to, occ) & bishopsQueens) | (rookAttacks(to, occ) & rooksQueens);
+        attackers &= occ;
+        onSquare = SEE_VALUE[t];
+        side ^= 1;
+    }
+
+    // Each side may decline a capture that loses material
+    while (d > 0) {
+        gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+        d--;
+    }
+    return gain[0];
+}
+
+bool Board::isSquareAttacked(int x, int y, PieceColor attackerColor) const {
+    return isAttacked(makeSquare(x, y), attackerColor);
+}
+
+bool Board::isAttacked(int sq, PieceColor attackerColor) const {
+    using namespace Bitboards;
+    const int c = colorIndex(attackerColor);
+    const Bitboard* bb = pieceBB[c];
+
+    // A pawn of the attacking color attacks sq exactly when a pawn of the other color on sq would attack it back.
+    if (pawnAttacks[c ^ 1][sq] & bb[0]) return true;
+    if (knightAttacks[sq] & bb[1]) return true;
+    if (kingAttacks[sq] & bb[5]) return true;
+    if (bishopAttacks(sq, occupied) & (bb[2] | bb[4])) return true;
+    if (rookAttacks(sq, occupied) & (bb[3] | bb[4])) return true;
+    return false;
+}
+
+bool Board::isInCheck(PieceColor color) const {
+    if (color == turn) return checkersBB != 0;
+    int sq = kingSq[colorIndex(color)];
+    return sq >= 0 && isAttacked(sq, opponent(color));
+}
+
+bool Board::hasLegalMoves(PieceColor color) const {
+    if (color != turn) {
+        Board other = *this;
+        other.turn = color;
+        other.epSquare = -1;
+        other.updateCheckInfo();
+        return other.hasLegalMoves(color);
+    }
+    MoveList moves;
+    generateMoves(moves);
+    return !moves.empty();
+}
+
+bool Board::isCheckmate(PieceColor color) const {
+    return isInCheck(color) && !hasLegalMoves(color);
+}
+
+bool Board::isStalemate(PieceColor color) const {
+    return !isInCheck(color) && !hasLegalMoves(color);
+}
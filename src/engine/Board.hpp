@@ -1,44 +1,135 @@
-#ifndef BOARD_HPP
-#define BOARD_HPP
-
-#include "Piece.hpp"
-#include <vector>
-#include <string>
-
-class Board {
-public:
-    Board();
-    void reset();
-    Piece getPiece(int x, int y) const;
-    bool movePiece(int startX, int startY, int endX, int endY);
-    bool isLegalMove(int startX, int startY, int endX, int endY) const;
-    bool isSquareAttacked(int x, int y, PieceColor attackerColor) const;
-    bool isInCheck(PieceColor color) const;
-    bool isCheckmate(PieceColor color) const;
-    bool isStalemate(PieceColor color) const;
-    bool hasLegalMoves(PieceColor color) const;
-    
-    PieceColor getTurn() const { return turn; }
-
-private:
-    Piece squares[8][8];
-    PieceColor turn;
-    
-    bool whiteKingMoved = false;
-    bool blackKingMoved = false;
-    bool whiteRookAMoved = false;
-    bool whiteRookHMoved = false;
-    bool blackRookAMoved = false;
-    bool blackRookHMoved = false;
-    
-    bool isValidPawnMove(int startX, int startY, int endX, int endY) const;
-    bool isValidKnightMove(int startX, int startY, int endX, int endY) const;
-    bool isValidBishopMove(int startX, int startY, int endX, int endY) const;
-    bool isValidRookMove(int startX, int startY, int endX, int endY) const;
-    bool isValidQueenMove(int startX, int startY, int endX, int endY) const;
-    bool isValidKingMove(int startX, int startY, int endX, int endY) const;
-    
-    bool isPathClear(int startX, int startY, int endX, int endY) const;
-};
-
-#endif
+#ifndef BOARD_HPP
+#define BOARD_HPP
+
+#include "Piece.hpp"
+#include "Bitboard.hpp"
+#include "Move.hpp"
+#include "Psqt.hpp"
+#include "Nnue.hpp"
+#include <vector>
+#include <string>
+
+enum CastlingRight : std::uint8_t {
+    WhiteKingSide = 1,
+    WhiteQueenSide = 2,
+    BlackKingSide = 4,
+    BlackQueenSide = 8,
+    AllCastling = 15
+};
+
+// Piece values used by the static exchange evaluation, indexed by typeIndex
+const int SEE_VALUE[6] = {100, 320, 330, 500, 900, 20000};
+
+// State that makeMove cannot recompute when taking a move back.
+struct UndoInfo {
+    std::uint64_t key;
+    std::uint8_t from, to;
+    PieceType promotion;
+    Piece captured;
+    std::uint8_t castlingRights;
+    std::int8_t epSquare;
+    std::uint16_t halfmoveClock;
+};
+
+class Board {
+public:
+    Board();
+    void reset();
+    // Sets up the position from a FEN string; the two move clocks may be left
+    // out. Leaves the board unchanged and returns false if the string is malformed.
+    bool fromFEN(const std::string& fen);
+    std::string toFEN() const;
+    Piece getPiece(int x, int y) const;
+    Piece pieceOn(int sq) const { return mailbox[sq]; }
+    bool movePiece(int startX, int startY, int endX, int endY, PieceType promotion = PieceType::Queen);
+    bool isLegalMove(int startX, int startY, int endX, int endY) const;
+    bool isSquareAttacked(int x, int y, PieceColor attackerColor) const;
+    bool isInCheck(PieceColor color) const;
+    bool isCheckmate(PieceColor color) const;
+    bool isStalemate(PieceColor color) const;
+    bool hasLegalMoves(PieceColor color) const;
+
+    // Legal moves for the side to move.
+    void generateMoves(MoveList& list, MoveGenType type = MoveGenType::All) const;
+    // Moves that follow the piece rules but may leave the own king in check.
+    void generatePseudoLegalMoves(MoveList& list, MoveGenType type = MoveGenType::All) const;
+    // Plays a move produced by generateMoves without validating it again.
+    void makeMove(const Move& m);
+    // Takes back the last move played with makeMove or movePiece.
+    void unmakeMove();
+    // Passes the turn, for null-move pruning. Not allowed while in check; take it
+    // back with unmakeNullMove before any other unmake.
+    void makeNullMove();
+    void unmakeNullMove();
+    // Whether a pseudo-legal move keeps the mover's king out of check, using the
+    // checkers and pinned pieces of the current position.
+    bool isLegal(const Move& m) const;
+
+    PieceColor getTurn() const { return turn; }
+    int getCastlingRights() const { return castlingRights; }
+    // -1 unless a pawn of the side to move can capture en passant
+    int getEnPassantSquare() const { return epSquare; }
+    int getPly() const { return static_cast<int>(history.size()); }
+    // Plies since the last capture or pawn move, for the fifty-move rule
+    int getHalfmoveClock() const { return halfmoveClock; }
+    int getFullmoveNumber() const { return fullmoveNumber; }
+    // Zobrist key of the position, kept up to date incrementally.
+    std::uint64_t getHash() const { return key; }
+    // Key of the pawns alone, for caching pawn-structure evaluation
+    std::uint64_t getPawnKey() const { return pawnKey; }
+
+    Bitboard pieces(PieceColor color, PieceType type) const { return pieceBB[colorIndex(color)][typeIndex(type)]; }
+    Bitboard pieces(PieceColor color) const { return colorBB[colorIndex(color)]; }
+    Bitboard occupancy() const { return occupied; }
+    Bitboard attackersTo(int sq, Bitboard occ) const;
+    int kingSquare(PieceColor color) const { return kingSq[colorIndex(color)]; }
+    // Enemy pieces giving check to the side to move
+    Bitboard checkers() const { return checkersBB; }
+    // Pieces of the side to move that cannot leave the line to their king
+    Bitboard pinned() const { return pinnedBB; }
+    // Static exchange evaluation: material the side to move wins (or loses, if
+    // negative) when both sides keep recapturing on the target square of m with
+    // their least valuable piece, each free to stop when that is better.
+    int see(const Move& m) const;
+
+    // Material plus piece-square sums for one side, updated as pieces move
+    const Psqt::Score& psqt(PieceColor color) const { return psqtScore[colorIndex(color)]; }
+    // Sum of Psqt::phaseWeight over the pieces on the board; MAX_PHASE at the start
+    int gamePhase() const { return phase; }
+    // Hidden layer sums of the loaded network. Computed in full on the first call
+    // after a load or a new position, then kept up to date as pieces move.
+    const Nnue::Accumulator& nnueAccumulator() const;
+
+private:
+    Bitboard pieceBB[2][6] = {};
+    Bitboard colorBB[2] = {};
+    Bitboard occupied = 0;
+    Piece mailbox[64];
+    PieceColor turn;
+    int epSquare = -1;
+    int halfmoveClock = 0;
+    int fullmoveNumber = 1;
+
+    std::uint8_t castlingRights = AllCastling;
+    std::uint64_t key = 0;
+    std::uint64_t pawnKey = 0;
+    int kingSq[2] = {-1, -1};
+    Bitboard checkersBB = 0;
+    Bitboard pinnedBB = 0;
+    Psqt::Score psqtScore[2];
+    int phase = 0;
+    mutable Nnue::Accumulator accumulator;
+    std::vector<UndoInfo> history;
+
+    void clear();
+    void putPiece(int sq, Piece p);
+    void removePiece(int sq);
+    bool isAttacked(int sq, PieceColor attackerColor) const;
+    // Recomputes checkersBB and pinnedBB for the side to move
+    void updateCheckInfo();
+
+    void generatePawnMoves(MoveList& list, MoveGenType type) const;
+    void generateCastlingMoves(MoveList& list) const;
+};
+
+#endif
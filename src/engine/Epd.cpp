@@ -0,0 +1,64 @@
+#include "Epd.hpp"
+#include <algorithm>
+#include <sstream>
+
+namespace {
+
+bool isClock(const std::string& field) {
+    return !field.empty() && field.find_first_not_of("0123456789") == std::string::npos;
+}
+
+}
+
+const std::vector<std::string>* EpdRecord::operands(std::string_view opcode) const {
+    for (const Operation& op : operations) {
+        if (op.opcode == opcode) return &op.operands;
+    }
+    return nullptr;
+}
+
+std::string EpdRecord::id() const {
+    std::string id;
+    if (const std::vector<std::string>* words = operands("id")) {
+        for (const std::string& w : *words) id += (id.empty() ? "" : " ") + w;
+        id.erase(std::remove(id.begin(), id.end(), '"'), id.end());
+    }
+    return id;
+}
+
+bool parseEpdLine(const std::string& line, EpdRecord& record) {
+    record.fen.clear();
+    record.operations.clear();
+
+    std::istringstream in(line);
+    std::string field;
+    for (int i = 0; i < 4; i++) {
+        if (!(in >> field)) return false;
+        record.fen += (i == 0 ? "" : " ") + field;
+    }
+    // A FEN's halfmove and fullmove clocks; an EPD opcode never starts with a digit
+    for (int i = 0; i < 2; i++) {
+        const std::streampos mark = in.tellg();
+        if (!(in >> field) || !isClock(field)) {
+            in.clear();
+            in.seekg(mark);
+            break;
+        }
+        record.fen += " " + field;
+    }
+
+    std::string op;
+    while (std::getline(in, op, ';')) {
+        std::istringstream words(op);
+        EpdRecord::Operation operation;
+        if (!(words >> operation.opcode)) continue;
+        while (words >> field) operation.operands.push_back(field);
+        record.operations.push_back(std::move(operation));
+    }
+    return true;
+}
+
+bool isEpdComment(const std::string& line) {
+    const std::size_t first = line.find_first_not_of(" \t\r");
+    return first == std::string::npos || line[first] == '#';
+}
@@ -0,0 +1,32 @@
+#ifndef EPD_HPP
+#define EPD_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// One line of an EPD or FEN file: the position fields, then any number of
+// "opcode operands;" operations.
+struct EpdRecord {
+    struct Operation {
+        std::string opcode;
+        std::vector<std::string> operands;   // as written, quotes included
+    };
+
+    std::string fen;   // the four EPD fields, and the move clocks when the line has them
+    std::vector<Operation> operations;
+
+    // Operands of the first operation with this opcode; null if there is none
+    const std::vector<std::string>* operands(std::string_view opcode) const;
+    // The id operation's operands joined by spaces, without quotes; empty if none
+    std::string id() const;
+};
+
+// Splits a line into its position and operations. False when it has fewer than
+// four fields; the position itself is left for Board::fromFEN to check.
+bool parseEpdLine(const std::string& line, EpdRecord& record);
+
+// Blank lines and '#' comments hold no position
+bool isEpdComment(const std::string& line);
+
+#endif
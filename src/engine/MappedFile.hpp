@@ -0,0 +1,34 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file. The pages are shared with the OS
+// file cache, so opening a large book or table costs no copy and no heap memory.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Maps the file, replacing any previous mapping. Returns false if it cannot
+    // be opened or is empty.
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return bytes != nullptr; }
+
+    const unsigned char* data() const { return bytes; }
+    std::size_t size() const { return length; }
+
+private:
+    unsigned char* bytes = nullptr;
+    std::size_t length = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef MOVE_HPP
+#define MOVE_HPP
+
+#include "Piece.hpp"
+
+struct Move {
+    int startX, startY;
+    int endX, endY;
+    int score;
+    PieceType promotion = PieceType::None;
+
+    bool sameSquares(const Move& other) const {
+        return startX == other.startX && startY == other.startY && endX == other.endX && endY == other.endY;
+    }
+    bool operator==(const Move& other) const { return sameSquares(other) && promotion == other.promotion; }
+    bool operator!=(const Move& other) const { return !(*this == other); }
+};
+
+// Fixed-capacity move buffer meant to live on the stack; 256 is above the most
+// moves any reachable position has.
+struct MoveList {
+    static constexpr int Capacity = 256;
+
+    Move moves[Capacity];
+    int count = 0;
+
+    void add(const Move& m) { moves[count++] = m; }
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    void clear() { count = 0; }
+
+    Move& operator[](int i) { return moves[i]; }
+    const Move& operator[](int i) const { return moves[i]; }
+    Move* begin() { return moves; }
+    Move* end() { return moves + count; }
+    const Move* begin() const { return moves; }
+    const Move* end() const { return moves + count; }
+};
+
+enum class MoveGenType {
+    All,       // every move
+    Captures   // captures, en passant and queen promotions
+};
+
+#endif
@@ -0,0 +1,137 @@
+#include "Board.hpp"
+
+using namespace Bitboards;
+
+namespace {
+
+inline Move toMove(int from, int to, PieceType promotion = PieceType::None) {
+    return {squareX(from), squareY(from), squareX(to), squareY(to), 0, promotion};
+}
+
+inline void addMoves(MoveList& list, int from, Bitboard targets) {
+    while (targets) list.add(toMove(from, popLsb(targets)));
+}
+
+inline void addPromotions(MoveList& list, int from, int to, MoveGenType type) {
+    list.add(toMove(from, to, PieceType::Queen));
+    if (type == MoveGenType::Captures) return;
+    list.add(toMove(from, to, PieceType::Knight));
+    list.add(toMove(from, to, PieceType::Rook));
+    list.add(toMove(from, to, PieceType::Bishop));
+}
+
+}
+
+void Board::generatePawnMoves(MoveList& list, MoveGenType type) const {
+    const int us = colorIndex(turn);
+    const bool white = (turn == PieceColor::White);
+    const int up = white ? 8 : -8;
+    const Bitboard promotionRank = white ? Rank8 : Rank1;
+    const Bitboard doublePushRank = white ? (Rank1 << 16) : (Rank1 << 40);
+    const Bitboard empty = ~occupied;
+    const Bitboard enemies = colorBB[us ^ 1];
+    const Bitboard pawns = pieceBB[us][0];
+
+    Bitboard singles = (white ? pawns << 8 : pawns >> 8) & empty;
+    Bitboard doubles = (white ? (singles & doublePushRank) << 8 : (singles & doublePushRank) >> 8) & empty;
+
+    Bitboard promotions = singles & promotionRank;
+    while (promotions) {
+        int to = popLsb(promotions);
+        addPromotions(list, to - up, to, type);
+    }
+
+    if (type == MoveGenType::All) {
+        Bitboard pushes = singles & ~promotionRank;
+        while (pushes) {
+            int to = popLsb(pushes);
+            list.add(toMove(to - up, to));
+        }
+        while (doubles) {
+            int to = popLsb(doubles);
+            list.add(toMove(to - 2 * up, to));
+        }
+    }
+
+    Bitboard b = pawns;
+    while (b) {
+        int from = popLsb(b);
+        Bitboard captures = pawnAttacks[us][from] & enemies;
+        while (captures) {
+            int to = popLsb(captures);
+            if (squareBB(to) & promotionRank) addPromotions(list, from, to, type);
+            else list.add(toMove(from, to));
+        }
+        if (epSquare >= 0 && (pawnAttacks[us][from] & squareBB(epSquare))) {
+            list.add(toMove(from, epSquare));
+        }
+    }
+}
+
+void Board::generateCastlingMoves(MoveList& list) const {
+    const bool white = (turn == PieceColor::White);
+    const int rights = castlingRights & (white ? (WhiteKingSide | WhiteQueenSide) : (BlackKingSide | BlackQueenSide));
+    if (!rights) return;
+
+    const int kingSq = white ? 4 : 60;
+    const PieceColor them = opponent(turn);
+    if (!(pieces(turn, PieceType::King) & squareBB(kingSq))) return;
+    if (checkersBB) return;
+
+    const Bitboard rooks = pieces(turn, PieceType::Rook);
+    if ((rights & (WhiteKingSide | BlackKingSide)) && (rooks & squareBB(kingSq + 3)) &&
+        !(betweenBB[kingSq][kingSq + 3] & occupied) &&
+        !isAttacked(kingSq + 1, them) &&
+        !isAttacked(kingSq + 2, them)) {
+        list.add(toMove(kingSq, kingSq + 2));
+    }
+    if ((rights & (WhiteQueenSide | BlackQueenSide)) && (rooks & squareBB(kingSq - 4)) &&
+        !(betweenBB[kingSq][kingSq - 4] & occupied) &&
+        !isAttacked(kingSq - 1, them) &&
+        !isAttacked(kingSq - 2, them)) {
+        list.add(toMove(kingSq, kingSq - 2));
+    }
+}
+
+void Board::generatePseudoLegalMoves(MoveList& list, MoveGenType type) const {
+    const int us = colorIndex(turn);
+    const Bitboard targets = (type == MoveGenType::Captures) ? colorBB[us ^ 1] : ~colorBB[us];
+
+    generatePawnMoves(list, type);
+
+    Bitboard b = pieceBB[us][1];
+    while (b) {
+        int from = popLsb(b);
+        addMoves(list, from, knightAttacks[from] & targets);
+    }
+    b = pieceBB[us][2];
+    while (b) {
+        int from = popLsb(b);
+        addMoves(list, from, bishopAttacks(from, occupied) & targets);
+    }
+    b = pieceBB[us][3];
+    while (b) {
+        int from = popLsb(b);
+        addMoves(list, from, rookAttacks(from, occupied) & targets);
+    }
+    b = pieceBB[us][4];
+    while (b) {
+        int from = popLsb(b);
+        addMoves(list, from, queenAttacks(from, occupied) & targets);
+    }
+    b = pieceBB[us][5];
+    while (b) {
+        int from = popLsb(b);
+        addMoves(list, from, kingAttacks[from] & targets);
+    }
+
+    if (type == MoveGenType::All) generateCastlingMoves(list);
+}
+
+void Board::generateMoves(MoveList& list, MoveGenType type) const {
+    MoveList pseudo;
+    generatePseudoLegalMoves(pseudo, type);
+    for (const Move& m : pseudo) {
+        if (isLegal(m)) list.add(m);
+    }
+}
@@ -0,0 +1,298 @@
+#include "Nnue.hpp"
+#include "Board.hpp"
+#include "MappedFile.hpp"
+#include <cstring>
+#include <memory>
+
+// The SIMD kernels are compiled for their instruction set one function at a time,
+// so the rest of the program keeps running on any x86 CPU
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NNUE_X86
+#define NNUE_TARGET(isa) __attribute__((target(isa)))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define NNUE_X86
+#define NNUE_TARGET(isa)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+using namespace Bitboards;
+
+namespace Nnue {
+
+std::uint32_t currentNetwork = 0;
+
+namespace {
+
+// File layout, all little-endian: the header below, then
+//   int16 featureWeights[INPUTS][HIDDEN]   one row per input
+//   int16 featureBias[HIDDEN]
+//   int16 outputWeights[2 * HIDDEN]        side to move's half first
+//   int32 outputBias
+struct FileHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t inputs;
+    std::uint32_t hidden;
+};
+constexpr char FILE_MAGIC[4] = {'A', 'J', 'N', 'N'};
+constexpr std::uint32_t FILE_VERSION = 1;
+constexpr std::size_t FILE_SIZE = sizeof(FileHeader) + 2 * (INPUTS * HIDDEN + HIDDEN + 2 * HIDDEN) + 4;
+
+struct Network {
+    std::unique_ptr<MappedFile> file;
+    std::string path;
+    const std::int16_t* featureWeights = nullptr;
+    const std::int16_t* featureBias = nullptr;
+    const std::int16_t* outputWeights = nullptr;
+    std::int32_t outputBias = 0;
+};
+
+Network network;
+std::uint32_t lastNetworkId = 0;
+
+// Input of piece p on sq as seen by perspective: the own pieces come first and
+// Black sees the board flipped, so one set of weights serves both sides
+inline int featureIndex(int perspective, int sq, Piece p) {
+    const int relativeColor = colorIndex(p.color) ^ perspective;
+    const int relativeSquare = perspective ? sq ^ 56 : sq;
+    return (relativeColor * 6 + typeIndex(p.type)) * 64 + relativeSquare;
+}
+
+// Portable kernels; the SIMD ones below compute exactly the same values
+void addRowScalar(std::int16_t* acc, const std::int16_t* row) {
+    for (int i = 0; i < HIDDEN; i++) acc[i] = static_cast<std::int16_t>(acc[i] + row[i]);
+}
+
+void subRowScalar(std::int16_t* acc, const std::int16_t* row) {
+    for (int i = 0; i < HIDDEN; i++) acc[i] = static_cast<std::int16_t>(acc[i] - row[i]);
+}
+
+std::int32_t outputScalar(const std::int16_t* us, const std::int16_t* them, const std::int16_t* weights) {
+    std::int32_t sum = 0;
+    for (int i = 0; i < HIDDEN; i++) {
+        int a = us[i] < 0 ? 0 : us[i] > QA ? QA : us[i];
+        int b = them[i] < 0 ? 0 : them[i] > QA ? QA : them[i];
+        sum += a * weights[i] + b * weights[HIDDEN + i];
+    }
+    return sum;
+}
+
+#ifdef NNUE_X86
+
+NNUE_TARGET("sse4.1") void addRowSse41(std::int16_t* acc, const std::int16_t* row) {
+    for (int i = 0; i < HIDDEN; i += 8) {
+        __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(acc + i));
+        __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        _mm_store_si128(reinterpret_cast<__m128i*>(acc + i), _mm_add_epi16(a, w));
+    }
+}
+
+NNUE_TARGET("sse4.1") void subRowSse41(std::int16_t* acc, const std::int16_t* row) {
+    for (int i = 0; i < HIDDEN; i += 8) {
+        __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(acc + i));
+        __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        _mm_store_si128(reinterpret_cast<__m128i*>(acc + i), _mm_sub_epi16(a, w));
+    }
+}
+
+NNUE_TARGET("sse4.1") std::int32_t outputSse41(const std::int16_t* us, const std::int16_t* them, const std::int16_t* weights) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i top = _mm_set1_epi16(QA);
+    __m128i sum = _mm_setzero_si128();
+    for (int side = 0; side < 2; side++) {
+        const std::int16_t* acc = side ? them : us;
+        const std::int16_t* w = weights + side * HIDDEN;
+        for (int i = 0; i < HIDDEN; i += 8) {
+            __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(acc + i));
+            a = _mm_min_epi16(_mm_max_epi16(a, zero), top);
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(a, _mm_loadu_si128(reinterpret_cast<const __m128i*>(w + i))));
+        }
+    }
+    sum = _mm_hadd_epi32(sum, sum);
+    sum = _mm_hadd_epi32(sum, sum);
+    return _mm_cvtsi128_si32(sum);
+}
+
+NNUE_TARGET("avx2") void addRowAvx2(std::int16_t* acc, const std::int16_t* row) {
+    for (int i = 0; i < HIDDEN; i += 16) {
+        __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(acc + i));
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(acc + i), _mm256_add_epi16(a, w));
+    }
+}
+
+NNUE_TARGET("avx2") void subRowAvx2(std::int16_t* acc, const std::int16_t* row) {
+    for (int i = 0; i < HIDDEN; i += 16) {
+        __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(acc + i));
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(acc + i), _mm256_sub_epi16(a, w));
+    }
+}
+
+NNUE_TARGET("avx2") std::int32_t outputAvx2(const std::int16_t* us, const std::int16_t* them, const std::int16_t* weights) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i top = _mm256_set1_epi16(QA);
+    __m256i sum = _mm256_setzero_si256();
+    for (int side = 0; side < 2; side++) {
+        const std::int16_t* acc = side ? them : us;
+        const std::int16_t* w = weights + side * HIDDEN;
+        for (int i = 0; i < HIDDEN; i += 16) {
+            __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(acc + i));
+            a = _mm256_min_epi16(_mm256_max_epi16(a, zero), top);
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(a, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + i))));
+        }
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_hadd_epi32(half, half);
+    half = _mm_hadd_epi32(half, half);
+    return _mm_cvtsi128_si32(half);
+}
+
+bool cpuSupports(Kernel k) {
+    if (k == Kernel::Scalar) return true;
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+    return k == Kernel::Avx2 ? __builtin_cpu_supports("avx2") : __builtin_cpu_supports("sse4.1");
+#else
+    int info[4];
+    __cpuid(info, 1);
+    if (k == Kernel::Sse41) return (info[2] >> 19) & 1;
+    // AVX2 also needs the OS to save the upper halves of the registers
+    const bool osSavesYmm = ((info[2] >> 27) & 1) && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return osSavesYmm && ((info[1] >> 5) & 1);
+#endif
+}
+
+#else
+
+bool cpuSupports(Kernel k) { return k == Kernel::Scalar; }
+
+#endif
+
+struct Kernels {
+    Kernel kind;
+    void (*addRow)(std::int16_t*, const std::int16_t*);
+    void (*subRow)(std::int16_t*, const std::int16_t*);
+    std::int32_t (*output)(const std::int16_t*, const std::int16_t*, const std::int16_t*);
+};
+
+const Kernels scalarKernels = {Kernel::Scalar, addRowScalar, subRowScalar, outputScalar};
+#ifdef NNUE_X86
+const Kernels sse41Kernels = {Kernel::Sse41, addRowSse41, subRowSse41, outputSse41};
+const Kernels avx2Kernels = {Kernel::Avx2, addRowAvx2, subRowAvx2, outputAvx2};
+#endif
+
+const Kernels* kernels = nullptr;
+
+const Kernels& activeKernels() {
+    if (!kernels) {
+        kernels = &scalarKernels;
+#ifdef NNUE_X86
+        if (cpuSupports(Kernel::Avx2)) kernels = &avx2Kernels;
+        else if (cpuSupports(Kernel::Sse41)) kernels = &sse41Kernels;
+#endif
+    }
+    return *kernels;
+}
+
+inline const std::int16_t* featureRow(int perspective, int sq, Piece p) {
+    return network.featureWeights + featureIndex(perspective, sq, p) * HIDDEN;
+}
+
+}
+
+bool load(const std::string& path) {
+    auto file = std::make_unique<MappedFile>();
+    if (!file->open(path) || file->size() != FILE_SIZE) return false;
+
+    FileHeader header;
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (std::memcmp(header.magic, FILE_MAGIC, 4) != 0 || header.version != FILE_VERSION ||
+        header.inputs != static_cast<std::uint32_t>(INPUTS) || header.hidden != static_cast<std::uint32_t>(HIDDEN)) {
+        return false;
+    }
+
+    const unsigned char* data = file->data() + sizeof(header);
+    network.featureWeights = reinterpret_cast<const std::int16_t*>(data);
+    network.featureBias = network.featureWeights + INPUTS * HIDDEN;
+    network.outputWeights = network.featureBias + HIDDEN;
+    std::memcpy(&network.outputBias, network.outputWeights + 2 * HIDDEN, sizeof(network.outputBias));
+    network.file = std::move(file);
+    network.path = path;
+    activeKernels();
+    // Accumulators computed with the previous network are now stale
+    currentNetwork = ++lastNetworkId;
+    return true;
+}
+
+void unload() {
+    currentNetwork = 0;
+    network = Network();
+}
+
+bool isLoaded() {
+    return currentNetwork != 0;
+}
+
+const std::string& loadedPath() {
+    return network.path;
+}
+
+Kernel kernel() {
+    return activeKernels().kind;
+}
+
+bool setKernel(Kernel k) {
+    if (!cpuSupports(k)) return false;
+#ifdef NNUE_X86
+    kernels = k == Kernel::Avx2 ? &avx2Kernels : k == Kernel::Sse41 ? &sse41Kernels : &scalarKernels;
+#else
+    kernels = &scalarKernels;
+#endif
+    return true;
+}
+
+const char* kernelName(Kernel k) {
+    switch (k) {
+        case Kernel::Avx2: return "avx2";
+        case Kernel::Sse41: return "sse4.1";
+        default: return "scalar";
+    }
+}
+
+void refresh(Accumulator& acc, const Board& board) {
+    const Kernels& k = activeKernels();
+    for (int perspective = 0; perspective < 2; perspective++) {
+        std::memcpy(acc.values[perspective], network.featureBias, sizeof(acc.values[perspective]));
+        Bitboard b = board.occupancy();
+        while (b) {
+            int sq = popLsb(b);
+            k.addRow(acc.values[perspective], featureRow(perspective, sq, board.pieceOn(sq)));
+        }
+    }
+    acc.network = currentNetwork;
+}
+
+void addPiece(Accumulator& acc, int sq, Piece p) {
+    const Kernels& k = *kernels;
+    k.addRow(acc.values[0], featureRow(0, sq, p));
+    k.addRow(acc.values[1], featureRow(1, sq, p));
+}
+
+void removePiece(Accumulator& acc, int sq, Piece p) {
+    const Kernels& k = *kernels;
+    k.subRow(acc.values[0], featureRow(0, sq, p));
+    k.subRow(acc.values[1], featureRow(1, sq, p));
+}
+
+int evaluate(const Board& board) {
+    const Accumulator& acc = board.nnueAccumulator();
+    const int us = colorIndex(board.getTurn());
+    std::int64_t sum = activeKernels().output(acc.values[us], acc.values[us ^ 1], network.outputWeights);
+    return static_cast<int>((sum + network.outputBias) * SCALE / (QA * QB));
+}
+
+}
@@ -0,0 +1,67 @@
+#ifndef NNUE_HPP
+#define NNUE_HPP
+
+#include "Piece.hpp"
+#include <cstdint>
+#include <string>
+
+class Board;
+
+// Optional neural network evaluation. The network has one input per piece type,
+// colour and square, seen from each side (768 inputs), a hidden layer of HIDDEN
+// neurons per side, and one output. The hidden layer sums (the accumulator) are
+// kept up to date by Board as pieces move, so an evaluation only has to run the
+// output layer.
+namespace Nnue {
+
+constexpr int INPUTS = 768;
+constexpr int HIDDEN = 256;
+// Quantisation: hidden activations are clipped to [0, QA], output weights are
+// scaled by QB, and the output is SCALE centipawns per unit
+constexpr int QA = 255;
+constexpr int QB = 64;
+constexpr int SCALE = 400;
+
+// Hidden layer sums from White's and Black's point of view. network is the id of
+// the network they were computed with, 0 if never.
+struct Accumulator {
+    alignas(32) std::int16_t values[2][HIDDEN];
+    std::uint32_t network = 0;
+};
+
+// Id of the loaded network, 0 when none is loaded; a new id on every load
+extern std::uint32_t currentNetwork;
+
+inline bool isCurrent(const Accumulator& acc) { return acc.network != 0 && acc.network == currentNetwork; }
+
+enum class Kernel {
+    Scalar,
+    Sse41,
+    Avx2
+};
+
+// Maps a weights file, replacing the current network. The previous network stays
+// if the file cannot be used. Not while a search is running.
+bool load(const std::string& path);
+void unload();
+bool isLoaded();
+const std::string& loadedPath();
+
+// The fastest kernel the CPU supports is picked on first use; setKernel forces a
+// slower one, for testing and benchmarks. Returns false if the CPU lacks it.
+Kernel kernel();
+bool setKernel(Kernel k);
+const char* kernelName(Kernel k);
+
+// Recomputes the accumulator from every piece on the board
+void refresh(Accumulator& acc, const Board& board);
+void addPiece(Accumulator& acc, int sq, Piece p);
+void removePiece(Accumulator& acc, int sq, Piece p);
+
+// Score of the position in centipawns from the side to move's point of view.
+// Only valid while a network is loaded.
+int evaluate(const Board& board);
+
+}
+
+#endif
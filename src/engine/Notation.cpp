@@ -0,0 +1,218 @@
+#include "Notation.hpp"
+
+namespace {
+
+char pieceLetter(PieceType t) {
+    switch (t) {
+        case PieceType::Knight: return 'N';
+        case PieceType::Bishop: return 'B';
+        case PieceType::Rook: return 'R';
+        case PieceType::Queen: return 'Q';
+        case PieceType::King: return 'K';
+        default: return 0;
+    }
+}
+
+PieceType pieceFromLetter(char letter) {
+    switch (letter) {
+        case 'N': case 'n': return PieceType::Knight;
+        case 'B': case 'b': return PieceType::Bishop;
+        case 'R': case 'r': return PieceType::Rook;
+        case 'Q': case 'q': return PieceType::Queen;
+        case 'K': case 'k': return PieceType::King;
+        default: return PieceType::None;
+    }
+}
+
+// SAN without the check or mate suffix
+std::string sanBody(const Board& board, const Move& m, const MoveList& legal) {
+    const Piece p = board.getPiece(m.startX, m.startY);
+    if (p.type == PieceType::King && m.endX - m.startX == 2) return "O-O";
+    if (p.type == PieceType::King && m.startX - m.endX == 2) return "O-O-O";
+
+    const bool capture = board.getPiece(m.endX, m.endY).type != PieceType::None ||
+                         (p.type == PieceType::Pawn && m.startX != m.endX);
+    std::string san;
+    if (p.type == PieceType::Pawn) {
+        if (capture) san += static_cast<char>('a' + m.startX);
+    } else {
+        san += pieceLetter(p.type);
+        // Name the file, the rank or both when another piece of the same kind can go there
+        bool ambiguous = false, sameFile = false, sameRank = false;
+        for (const Move& other : legal) {
+            if (other.endX != m.endX || other.endY != m.endY || other.sameSquares(m)) continue;
+            if (board.getPiece(other.startX, other.startY).type != p.type) continue;
+            ambiguous = true;
+            if (other.startX == m.startX) sameFile = true;
+            if (other.startY == m.startY) sameRank = true;
+        }
+        if (ambiguous) {
+            if (!sameFile) san += static_cast<char>('a' + m.startX);
+            else if (!sameRank) san += static_cast<char>('8' - m.startY);
+            else san += squareName(m.startX, m.startY);
+        }
+    }
+    if (capture) san += 'x';
+    san += squareName(m.endX, m.endY);
+    if (m.promotion != PieceType::None) {
+        san += '=';
+        san += pieceLetter(m.promotion);
+    }
+    return san;
+}
+
+}
+
+std::string squareName(int x, int y) {
+    std::string name;
+    name += static_cast<char>('a' + x);
+    name += static_cast<char>('8' - y);
+    return name;
+}
+
+std::string moveToUci(const Move& m) {
+    if (m.startX < 0) return "0000";
+    std::string uci = squareName(m.startX, m.startY) + squareName(m.endX, m.endY);
+    switch (m.promotion) {
+        case PieceType::Knight: uci += 'n'; break;
+        case PieceType::Bishop: uci += 'b'; break;
+        case PieceType::Rook: uci += 'r'; break;
+        case PieceType::Queen: uci += 'q'; break;
+        default: break;
+    }
+    return uci;
+}
+
+bool parseUciMove(const Board& board, const std::string& text, Move& move) {
+    if (text.size() != 4 && text.size() != 5) return false;
+    if (text[0] < 'a' || text[0] > 'h' || text[1] < '1' || text[1] > '8' ||
+        text[2] < 'a' || text[2] > 'h' || text[3] < '1' || text[3] > '8') return false;
+
+    Move wanted = {text[0] - 'a', '8' - text[1], text[2] - 'a', '8' - text[3], 0};
+    if (text.size() == 5) {
+        switch (text[4]) {
+            case 'n': wanted.promotion = PieceType::Knight; break;
+            case 'b': wanted.promotion = PieceType::Bishop; break;
+            case 'r': wanted.promotion = PieceType::Rook; break;
+            case 'q': wanted.promotion = PieceType::Queen; break;
+            default: return false;
+        }
+    }
+
+    MoveList moves;
+    board.generateMoves(moves);
+    for (const Move& m : moves) {
+        if (m == wanted) {
+            move = m;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string moveToSan(const Board& board, const Move& m) {
+    MoveList legal;
+    board.generateMoves(legal);
+    std::string san = sanBody(board, m, legal);
+
+    Board after = board;
+    after.makeMove(m);
+    if (after.isInCheck(after.getTurn())) san += after.hasLegalMoves(after.getTurn()) ? '+' : '#';
+    return san;
+}
+
+bool parseSanMove(const Board& board, std::string_view text, Move& move) {
+    while (!text.empty() && (text.back() == '+' || text.back() == '#' || text.back() == '!' || text.back() == '?')) {
+        text.remove_suffix(1);
+    }
+    if (text.empty()) return false;
+    const PieceColor us = board.getTurn();
+
+    if (text == "O-O" || text == "0-0" || text == "O-O-O" || text == "0-0-0") {
+        const int step = text.size() == 3 ? 2 : -2;
+        MoveList legal;
+        board.generateMoves(legal);
+        for (const Move& m : legal) {
+            if (makeSquare(m.startX, m.startY) == board.kingSquare(us) && m.endX - m.startX == step) {
+                move = m;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Piece letters are upper case; a pawn move starts with its file
+    PieceType type = PieceType::Pawn;
+    if (text[0] >= 'A' && text[0] <= 'Z') {
+        type = pieceFromLetter(text[0]);
+        if (type == PieceType::None) return false;
+        text.remove_prefix(1);
+    }
+
+    // Promotions are also written without the '=' ("e8Q") or in lower case ("e8q")
+    PieceType promotion = PieceType::None;
+    if (type == PieceType::Pawn && text.size() >= 3 && !(text.back() >= '1' && text.back() <= '8')) {
+        promotion = pieceFromLetter(text.back());
+        if (promotion == PieceType::None || promotion == PieceType::Pawn || promotion == PieceType::King) return false;
+        text.remove_suffix(1);
+        if (text.back() == '=') text.remove_suffix(1);
+    }
+
+    if (text.size() < 2) return false;
+    const char file = text[text.size() - 2], rank = text[text.size() - 1];
+    if (file < 'a' || file > 'h' || rank < '1' || rank > '8') return false;
+    const int to = (rank - '1') * 8 + (file - 'a');
+    text.remove_suffix(2);
+
+    // Whatever is left names the origin file, rank or both ("Nbd2", "R1e2", "Ng1f3", "exd5")
+    int fromFile = -1, fromRank = -1;
+    for (char ch : text) {
+        if (ch >= 'a' && ch <= 'h') fromFile = ch - 'a';
+        else if (ch >= '1' && ch <= '8') fromRank = ch - '1';
+        else if (ch != 'x' && ch != ':' && ch != '-') return false;
+    }
+
+    // Pieces of the named kind that reach the target square under the piece rules
+    using namespace Bitboards;
+    const Bitboard occupied = board.occupancy();
+    const Bitboard target = squareBB(to);
+    if (board.pieces(us) & target) return false;
+    Bitboard candidates = board.pieces(us, type);
+    switch (type) {
+        case PieceType::Knight: candidates &= knightAttacks[to]; break;
+        case PieceType::Bishop: candidates &= bishopAttacks(to, occupied); break;
+        case PieceType::Rook: candidates &= rookAttacks(to, occupied); break;
+        case PieceType::Queen: candidates &= queenAttacks(to, occupied); break;
+        case PieceType::King: candidates &= kingAttacks[to]; break;
+        default: {
+            const bool white = us == PieceColor::White;
+            Bitboard origins = 0;
+            if ((board.pieces(opponent(us)) & target) || to == board.getEnPassantSquare()) {
+                origins = pawnAttacks[colorIndex(opponent(us))][to];
+            } else if (!(occupied & target)) {
+                const int behind = white ? to - 8 : to + 8;
+                if (behind >= 0 && behind < 64) {
+                    origins = squareBB(behind);
+                    const int start = white ? to - 16 : to + 16;
+                    const bool doublePush = white ? (to >> 3) == 3 : (to >> 3) == 4;
+                    if (doublePush && !(occupied & origins)) origins |= squareBB(start);
+                }
+            }
+            candidates &= origins;
+            const bool lastRank = (to >> 3) == (white ? 7 : 0);
+            if (lastRank != (promotion != PieceType::None)) return false;
+        }
+    }
+
+    int found = 0;
+    while (candidates) {
+        const int from = popLsb(candidates);
+        if ((fromFile >= 0 && (from & 7) != fromFile) || (fromRank >= 0 && (from >> 3) != fromRank)) continue;
+        Move m = {squareX(from), squareY(from), squareX(to), squareY(to), 0, promotion};
+        if (!board.isLegal(m)) continue;
+        move = m;
+        found++;
+    }
+    // An ambiguous move names no move at all
+    return found == 1;
+}
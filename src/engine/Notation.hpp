@@ -0,0 +1,24 @@
+#ifndef NOTATION_HPP
+#define NOTATION_HPP
+
+#include "Board.hpp"
+#include "Move.hpp"
+#include <string>
+#include <string_view>
+
+// Coordinate notation as used by UCI, e.g. "e2e4" or "e7e8q".
+std::string moveToUci(const Move& m);
+std::string squareName(int x, int y);
+// Finds the legal move written in coordinate notation. Returns false if the text
+// is malformed or the move is not legal in this position.
+bool parseUciMove(const Board& board, const std::string& text, Move& move);
+
+// Standard algebraic notation, e.g. "Nf3", "exd5", "O-O" or "e8=Q+", for a legal move.
+std::string moveToSan(const Board& board, const Move& m);
+// Accepts check marks, annotations ("!", "?"), "0-0" style castling and origin squares
+// given in full ("Ng1f3"). Resolved against the pieces that can reach the target
+// square, without generating every move. Returns false if no legal move matches
+// or more than one does.
+bool parseSanMove(const Board& board, std::string_view text, Move& move);
+
+#endif
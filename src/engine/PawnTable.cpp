@@ -0,0 +1,83 @@
+#include "PawnTable.hpp"
+
+using namespace Bitboards;
+
+namespace {
+
+const Psqt::Score DOUBLED = {-10, -20};
+const Psqt::Score ISOLATED = {-10, -15};
+const Psqt::Score BACKWARD = {-8, -10};
+// Passed pawn bonus by rank counted from the pawn's own side
+const Psqt::Score PASSED[8] = {{0, 0}, {5, 10}, {10, 20}, {15, 35}, {30, 60}, {50, 100}, {80, 150}, {0, 0}};
+
+inline Bitboard fileBB(int file) { return FileA << file; }
+
+inline Bitboard adjacentFiles(int file) {
+    return (file > 0 ? fileBB(file - 1) : 0) | (file < 7 ? fileBB(file + 1) : 0);
+}
+
+// Ranks strictly in front of sq as seen by color c (0 = White)
+inline Bitboard forwardRanks(int c, int sq) {
+    const int rank = sq >> 3;
+    if (c == 0) return rank == 7 ? 0 : ~0ULL << (8 * (rank + 1));
+    return rank == 0 ? 0 : ~0ULL >> (8 * (8 - rank));
+}
+
+Psqt::Score evaluateSide(int c, Bitboard ours, Bitboard theirs) {
+    Psqt::Score score;
+    Bitboard b = ours;
+    while (b) {
+        const int sq = popLsb(b);
+        const int file = sq & 7;
+        const Bitboard front = forwardRanks(c, sq);
+        const Bitboard adjacent = adjacentFiles(file);
+        const bool blockedByOwn = (ours & fileBB(file) & front) != 0;
+
+        // Only the rear pawn of a doubled pair is counted, so a pair costs once
+        if (blockedByOwn) score += DOUBLED;
+        if (!(ours & adjacent)) {
+            score += ISOLATED;
+        } else if (!(ours & adjacent & ~front)) {
+            // No neighbour level with or behind it can ever defend it, and an
+            // enemy pawn stops it advancing to find one
+            const int stop = c == 0 ? sq + 8 : sq - 8;
+            if (pawnAttacks[c][stop] & theirs) score += BACKWARD;
+        }
+        if (!blockedByOwn && !(theirs & (fileBB(file) | adjacent) & front)) {
+            score += PASSED[c == 0 ? sq >> 3 : 7 - (sq >> 3)];
+        }
+    }
+    return score;
+}
+
+}
+
+PawnTable::PawnTable(std::size_t count) {
+    std::size_t size = 1;
+    while (size * 2 <= count) size *= 2;
+    entries.resize(size);
+}
+
+void PawnTable::clear() {
+    for (Entry& e : entries) e = Entry();
+}
+
+Psqt::Score PawnTable::probe(const Board& board, bool& hit) {
+    const std::uint64_t key = board.getPawnKey();
+    Entry& e = entries[key & (entries.size() - 1)];
+    // A pawnless board has key 0, which matches the empty entries' zero score
+    hit = e.key == key;
+    if (!hit) {
+        e.key = key;
+        e.score = evaluate(board);
+    }
+    return e.score;
+}
+
+Psqt::Score PawnTable::evaluate(const Board& board) {
+    const Bitboard white = board.pieces(PieceColor::White, PieceType::Pawn);
+    const Bitboard black = board.pieces(PieceColor::Black, PieceType::Pawn);
+    Psqt::Score score = evaluateSide(0, white, black);
+    score -= evaluateSide(1, black, white);
+    return score;
+}
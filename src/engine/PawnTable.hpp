@@ -0,0 +1,32 @@
+#ifndef PAWNTABLE_HPP
+#define PAWNTABLE_HPP
+
+#include "Board.hpp"
+#include "Psqt.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Cache of pawn-structure scores keyed by Board::getPawnKey. Pawns move rarely, so
+// almost every probe during a search hits. Not shared: each search thread owns one.
+class PawnTable {
+public:
+    explicit PawnTable(std::size_t entries = 1 << 15);
+
+    // Structure score of the position's pawns, white minus black; hit tells
+    // whether it came from the table.
+    Psqt::Score probe(const Board& board, bool& hit);
+    void clear();
+
+    // Passed, doubled, isolated and backward pawn terms, computed from scratch.
+    static Psqt::Score evaluate(const Board& board);
+
+private:
+    struct Entry {
+        std::uint64_t key = 0;
+        Psqt::Score score;
+    };
+    std::vector<Entry> entries;
+};
+
+#endif
@@ -0,0 +1,119 @@
+#include "Pgn.hpp"
+
+namespace {
+
+inline bool isSpace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+// Index just past the end of the line containing pos
+std::size_t lineEnd(std::string_view text, std::size_t pos) {
+    std::size_t end = text.find('\n', pos);
+    return end == std::string_view::npos ? text.size() : end + 1;
+}
+
+}
+
+std::string_view PgnGame::tag(std::string_view name) const {
+    for (std::size_t pos = 0; pos < tags.size(); pos = lineEnd(tags, pos)) {
+        std::string_view line = tags.substr(pos, lineEnd(tags, pos) - pos);
+        if (line.size() < name.size() + 2 || line[0] != '[' || line.compare(1, name.size(), name) != 0 ||
+            !isSpace(line[name.size() + 1])) {
+            continue;
+        }
+        std::size_t open = line.find('"');
+        std::size_t close = line.rfind('"');
+        if (open == std::string_view::npos || close <= open) return {};
+        return line.substr(open + 1, close - open - 1);
+    }
+    return {};
+}
+
+bool PgnReader::next(PgnGame& game) {
+    if (pos == 0 && text.substr(0, 3) == "\xEF\xBB\xBF") pos = 3;
+    while (pos < text.size() && isSpace(text[pos])) pos++;
+    if (pos >= text.size()) return false;
+
+    const std::size_t tagStart = pos;
+    while (pos < text.size() && text[pos] == '[') {
+        pos = lineEnd(text, pos);
+        while (pos < text.size() && isSpace(text[pos])) pos++;
+    }
+    game.tags = text.substr(tagStart, pos - tagStart);
+
+    // The movetext runs up to the next tag at the start of a line; a '[' inside a
+    // comment does not count
+    const std::size_t moveStart = pos;
+    bool inComment = false;
+    for (; pos < text.size(); pos++) {
+        const char c = text[pos];
+        if (inComment) {
+            if (c == '}') inComment = false;
+        } else if (c == '{') {
+            inComment = true;
+        } else if (c == '[' && text[pos - 1] == '\n') {
+            break;
+        }
+    }
+    game.movetext = text.substr(moveStart, pos - moveStart);
+    return true;
+}
+
+bool PgnMoveTokens::next(std::string_view& move) {
+    while (pos < text.size()) {
+        const char c = text[pos];
+        if (isSpace(c) || c == '.') {
+            pos++;
+        } else if (c == '{') {
+            std::size_t end = text.find('}', pos);
+            pos = end == std::string_view::npos ? text.size() : end + 1;
+        } else if (c == ';' || c == '%') {
+            pos = lineEnd(text, pos);
+        } else if (c == '(') {
+            // Variations nest and may hold comments with parentheses in them
+            int depth = 0;
+            for (; pos < text.size(); pos++) {
+                if (text[pos] == '{') {
+                    std::size_t end = text.find('}', pos);
+                    if (end == std::string_view::npos) break;
+                    pos = end;
+                } else if (text[pos] == '(') {
+                    depth++;
+                } else if (text[pos] == ')' && --depth == 0) {
+                    break;
+                }
+            }
+            pos = pos < text.size() ? pos + 1 : pos;
+        } else if (c == '$') {
+            pos++;
+            while (pos < text.size() && isDigit(text[pos])) pos++;
+        } else if (c == '*') {
+            pos = text.size();
+        } else if (isDigit(c) && text.compare(pos, 3, "0-0") != 0) {
+            // A move number, or the result ("1-0", "0-1", "1/2-1/2")
+            while (pos < text.size() && isDigit(text[pos])) pos++;
+            if (pos < text.size() && text[pos] != '.' && !isSpace(text[pos])) pos = text.size();
+        } else {
+            const std::size_t start = pos;
+            while (pos < text.size() && !isSpace(text[pos]) && text[pos] != '{' && text[pos] != '(' &&
+                   text[pos] != ')' && text[pos] != ';' && text[pos] != '$') {
+                pos++;
+            }
+            move = text.substr(start, pos - start);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::size_t findGameStart(std::string_view text, std::size_t offset) {
+    if (offset == 0) return 0;
+    // A tag line whose previous line is not a tag line starts a game
+    for (std::size_t from = offset - 1;;) {
+        std::size_t newline = text.find("\n[", from);
+        if (newline == std::string_view::npos) return text.size();
+        std::size_t previous = newline == 0 ? std::string_view::npos : text.rfind('\n', newline - 1);
+        std::size_t previousStart = previous == std::string_view::npos ? 0 : previous + 1;
+        if (text[previousStart] != '[') return newline + 1;
+        from = newline + 1;
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef PGN_HPP
+#define PGN_HPP
+
+#include <cstddef>
+#include <string_view>
+
+// One game of a PGN text. The views point into the text being read, so they
+// are only valid as long as it is.
+struct PgnGame {
+    std::string_view tags;       // the tag pair section, "[Name "Value"]" lines
+    std::string_view movetext;   // moves, comments and the result
+
+    // Value of a tag pair, without the quotes; empty if the game has none
+    std::string_view tag(std::string_view name) const;
+};
+
+// Splits a PGN text into games without copying it; meant for memory-mapped files.
+class PgnReader {
+public:
+    explicit PgnReader(std::string_view text) : text(text) {}
+    // The next game; false at the end of the text
+    bool next(PgnGame& game);
+
+private:
+    std::string_view text;
+    std::size_t pos = 0;
+};
+
+// The moves of a game's movetext in order, as written (SAN with any check marks
+// and annotations). Move numbers, comments, NAGs and variations are skipped; the
+// result token ends the game.
+class PgnMoveTokens {
+public:
+    explicit PgnMoveTokens(std::string_view movetext) : text(movetext) {}
+    bool next(std::string_view& move);
+
+private:
+    std::string_view text;
+    std::size_t pos = 0;
+};
+
+// Where the next game starts at or after offset, so that a text can be split
+// into chunks read on separate threads; text.size() if there is none.
+std::size_t findGameStart(std::string_view text, std::size_t offset);
+
+#endif
@@ -1,17 +1,24 @@
-#ifndef PIECE_HPP
-#define PIECE_HPP
-
-enum class PieceType {
-    None, Pawn, Knight, Bishop, Rook, Queen, King
-};
-
-enum class PieceColor {
-    None, White, Black
-};
-
-struct Piece {
-    PieceType type = PieceType::None;
-    PieceColor color = PieceColor::None;
-};
-
-#endif
+#ifndef PIECE_HPP
+#define PIECE_HPP
+
+#include <cstdint>
+
+enum class PieceType : std::uint8_t {
+    None, Pawn, Knight, Bishop, Rook, Queen, King
+};
+
+enum class PieceColor : std::uint8_t {
+    None, White, Black
+};
+
+struct Piece {
+    PieceType type = PieceType::None;
+    PieceColor color = PieceColor::None;
+};
+
+// Array indices for bitboard and table lookups: White = 0, Black = 1 and Pawn = 0 ... King = 5.
+inline int colorIndex(PieceColor c) { return static_cast<int>(c) - 1; }
+inline int typeIndex(PieceType t) { return static_cast<int>(t) - 1; }
+inline PieceColor opponent(PieceColor c) { return c == PieceColor::White ? PieceColor::Black : PieceColor::White; }
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef POLYGLOTBOOK_HPP
+#define POLYGLOTBOOK_HPP
+
+#include "Board.hpp"
+#include "MappedFile.hpp"
+#include <cstdint>
+#include <string>
+
+// Opening book in the Polyglot .bin format: 16-byte big-endian entries of
+// (key, move, weight, learn) sorted by key. The file is memory-mapped and
+// searched in place.
+class PolyglotBook {
+public:
+    bool open(const std::string& path);
+    void close() { file.close(); }
+    bool isOpen() const { return file.isOpen(); }
+    std::size_t entryCount() const { return file.size() / ENTRY_SIZE; }
+
+    // Picks one of the position's book moves with probability proportional to
+    // its weight; random is any uniformly distributed 64-bit value. Returns false
+    // when the position is not in the book. Does not allocate.
+    bool probe(const Board& board, std::uint64_t random, Move& move) const;
+
+    // The Polyglot hash of a position, which differs from Board::getHash.
+    static std::uint64_t key(const Board& board);
+
+private:
+    static constexpr std::size_t ENTRY_SIZE = 16;
+
+    std::uint64_t entryKey(std::size_t i) const;
+    std::uint16_t entryMove(std::size_t i) const;
+    std::uint16_t entryWeight(std::size_t i) const;
+
+    MappedFile file;
+};
+
+#endif
@@ -0,0 +1,128 @@
+#include "Psqt.hpp"
+#include <mutex>
+
+namespace Psqt {
+
+Score table[2][6][64];
+const int phaseWeight[6] = {0, 1, 1, 2, 4, 0};
+
+namespace {
+
+const int mgValue[6] = {100, 320, 330, 500, 900, 0};
+const int egValue[6] = {120, 300, 330, 520, 940, 0};
+
+// Piece-square tables from White's point of view, rank 8 first as printed
+const int pawnPST[8][8] = {
+    { 0,  0,  0,  0,  0,  0,  0,  0},
+    {50, 50, 50, 50, 50, 50, 50, 50},
+    {10, 10, 20, 30, 30, 20, 10, 10},
+    { 5,  5, 10, 25, 25, 10,  5,  5},
+    { 0,  0,  0, 20, 20,  0,  0,  0},
+    { 5, -5,-10,  0,  0,-10, -5,  5},
+    { 5, 10, 10,-20,-20, 10, 10,  5},
+    { 0,  0,  0,  0,  0,  0,  0,  0}
+};
+
+// In the endgame passed pawns matter more than central control
+const int pawnEndgamePST[8][8] = {
+    { 0,  0,  0,  0,  0,  0,  0,  0},
+    {80, 80, 80, 80, 80, 80, 80, 80},
+    {50, 50, 50, 50, 50, 50, 50, 50},
+    {30, 30, 30, 30, 30, 30, 30, 30},
+    {15, 15, 15, 15, 15, 15, 15, 15},
+    { 5,  5,  5,  5,  5,  5,  5,  5},
+    { 0,  0,  0,  0,  0,  0,  0,  0},
+    { 0,  0,  0,  0,  0,  0,  0,  0}
+};
+
+const int knightPST[8][8] = {
+    {-50,-40,-30,-30,-30,-30,-40,-50},
+    {-40,-20,  0,  0,  0,  0,-20,-40},
+    {-30,  0, 10, 15, 15, 10,  0,-30},
+    {-30,  5, 15, 20, 20, 15,  5,-30},
+    {-30,  0, 15, 20, 20, 15,  0,-30},
+    {-30,  5, 10, 15, 15, 10,  5,-30},
+    {-40,-20,  0,  5,  5,  0,-20,-40},
+    {-50,-40,-30,-30,-30,-30,-40,-50}
+};
+
+const int bishopPST[8][8] = {
+    {-20,-10,-10,-10,-10,-10,-10,-20},
+    {-10,  0,  0,  0,  0,  0,  0,-10},
+    {-10,  0,  5, 10, 10,  5,  0,-10},
+    {-10,  5,  5, 10, 10,  5,  5,-10},
+    {-10,  0, 10, 10, 10, 10,  0,-10},
+    {-10, 10, 10, 10, 10, 10, 10,-10},
+    {-10,  5,  0,  0,  0,  0,  5,-10},
+    {-20,-10,-10,-10,-10,-10,-10,-20}
+};
+
+const int rookPST[8][8] = {
+    { 0,  0,  0,  0,  0,  0,  0,  0},
+    { 5, 10, 10, 10, 10, 10, 10,  5},
+    {-5,  0,  0,  0,  0,  0,  0, -5},
+    {-5,  0,  0,  0,  0,  0,  0, -5},
+    {-5,  0,  0,  0,  0,  0,  0, -5},
+    {-5,  0,  0,  0,  0,  0,  0, -5},
+    {-5,  0,  0,  0,  0,  0,  0, -5},
+    { 0,  0,  0,  5,  5,  0,  0,  0}
+};
+
+const int queenPST[8][8] = {
+    {-20,-10,-10, -5, -5,-10,-10,-20},
+    {-10,  0,  0,  0,  0,  0,  0,-10},
+    {-10,  0,  5,  5,  5,  5,  0,-10},
+    { -5,  0,  5,  5,  5,  5,  0, -5},
+    {  0,  0,  5,  5,  5,  5,  0, -5},
+    {-10,  5,  5,  5,  5,  5,  0,-10},
+    {-10,  0,  5,  0,  0,  0,  0,-10},
+    {-20,-10,-10, -5, -5,-10,-10,-20}
+};
+
+const int kingPST[8][8] = {
+    {-30,-40,-40,-50,-50,-40,-40,-30},
+    {-30,-40,-40,-50,-50,-40,-40,-30},
+    {-30,-40,-40,-50,-50,-40,-40,-30},
+    {-30,-40,-40,-50,-50,-40,-40,-30},
+    {-20,-30,-30,-40,-40,-30,-30,-20},
+    {-10,-20,-20,-20,-20,-20,-20,-10},
+    { 20, 20,  0,  0,  0,  0, 20, 20},
+    { 20, 30, 10,  0,  0, 10, 30, 20}
+};
+
+// With the queens off the king should walk to the centre
+const int kingEndgamePST[8][8] = {
+    {-50,-40,-30,-20,-20,-30,-40,-50},
+    {-30,-20,-10,  0,  0,-10,-20,-30},
+    {-30,-10, 20, 30, 30, 20,-10,-30},
+    {-30,-10, 30, 40, 40, 30,-10,-30},
+    {-30,-10, 30, 40, 40, 30,-10,-30},
+    {-30,-10, 20, 30, 30, 20,-10,-30},
+    {-30,-30,  0,  0,  0,  0,-30,-30},
+    {-50,-30,-30,-30,-30,-30,-30,-50}
+};
+
+const int (*mgTables[6])[8] = {pawnPST, knightPST, bishopPST, rookPST, queenPST, kingPST};
+const int (*egTables[6])[8] = {pawnEndgamePST, knightPST, bishopPST, rookPST, queenPST, kingEndgamePST};
+
+void initTable() {
+    for (int t = 0; t < 6; t++) {
+        for (int sq = 0; sq < 64; sq++) {
+            // Rows are printed rank 8 first; Black reads the table upside down
+            int file = sq & 7;
+            int whiteRow = 7 - (sq >> 3);
+            int blackRow = sq >> 3;
+            table[0][t][sq] = {mgValue[t] + mgTables[t][whiteRow][file], egValue[t] + egTables[t][whiteRow][file]};
+            table[1][t][sq] = {mgValue[t] + mgTables[t][blackRow][file], egValue[t] + egTables[t][blackRow][file]};
+        }
+    }
+}
+
+}
+
+void init() {
+    static std::once_flag flag;
+    std::call_once(flag, initTable);
+}
+
+}
@@ -0,0 +1,36 @@
+#ifndef PSQT_HPP
+#define PSQT_HPP
+
+#include "Piece.hpp"
+
+// Material plus piece-square values, in centipawns from the owner's point of
+// view. Board keeps running sums of these so evaluation does not scan the board.
+namespace Psqt {
+
+struct Score {
+    int mg = 0;
+    int eg = 0;
+
+    Score& operator+=(const Score& o) { mg += o.mg; eg += o.eg; return *this; }
+    Score& operator-=(const Score& o) { mg -= o.mg; eg -= o.eg; return *this; }
+};
+
+// Indexed by colorIndex, typeIndex and square (a1 = 0); Black's rows are already mirrored
+extern Score table[2][6][64];
+
+// Game phase contributed by each piece type; the opening position has MAX_PHASE
+extern const int phaseWeight[6];
+const int MAX_PHASE = 24;
+
+// Fills the table. Safe to call more than once.
+void init();
+
+// Interpolates between the middlegame and endgame values by game phase.
+inline int taper(const Score& s, int phase) {
+    if (phase > MAX_PHASE) phase = MAX_PHASE;
+    return (s.mg * phase + s.eg * (MAX_PHASE - phase)) / MAX_PHASE;
+}
+
+}
+
+#endif
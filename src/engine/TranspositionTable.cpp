@@ -0,0 +1,121 @@
+#include "TranspositionTable.hpp"
+#include "Bitboard.hpp"
+
+namespace {
+
+// data layout: move (16 bits) | score (32) | depth (8) | bound (2) | generation (6)
+std::uint64_t packMove(const Move& m) {
+    if (m.startX < 0) return 0;
+    std::uint64_t from = makeSquare(m.startX, m.startY);
+    std::uint64_t to = makeSquare(m.endX, m.endY);
+    return from | (to << 6) | (static_cast<std::uint64_t>(m.promotion) << 12);
+}
+
+Move unpackMove(std::uint64_t bits) {
+    int from = bits & 63;
+    int to = (bits >> 6) & 63;
+    if (from == to) return {-1, -1, -1, -1, 0};
+    return {squareX(from), squareY(from), squareX(to), squareY(to), 0, static_cast<PieceType>((bits >> 12) & 7)};
+}
+
+std::uint64_t pack(const Move& move, int score, int depth, Bound bound, std::uint8_t generation) {
+    return packMove(move)
+         | (static_cast<std::uint64_t>(static_cast<std::uint32_t>(score)) << 16)
+         | (static_cast<std::uint64_t>(static_cast<std::uint8_t>(depth)) << 48)
+         | (static_cast<std::uint64_t>(bound) << 56)
+         | (static_cast<std::uint64_t>(generation & 63) << 58);
+}
+
+int depthOf(std::uint64_t data) { return static_cast<std::int8_t>((data >> 48) & 0xFF); }
+Bound boundOf(std::uint64_t data) { return static_cast<Bound>((data >> 56) & 3); }
+std::uint8_t generationOf(std::uint64_t data) { return (data >> 58) & 63; }
+
+}
+
+TranspositionTable::TranspositionTable(std::size_t megabytes) {
+    resize(megabytes);
+}
+
+void TranspositionTable::resize(std::size_t megabytes) {
+    // Round down to a power of two so the bucket index is a mask
+    std::size_t count = 1;
+    const std::size_t wanted = (megabytes == 0 ? 1 : megabytes) * 1024 * 1024 / sizeof(Bucket);
+    while (count * 2 <= wanted) count *= 2;
+    std::vector<Bucket>(count).swap(buckets);
+    generation = 0;
+}
+
+void TranspositionTable::clear() {
+    for (Bucket& b : buckets) {
+        for (Entry& e : b.entries) {
+            e.keyXorData.store(0, std::memory_order_relaxed);
+            e.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    generation = 0;
+}
+
+void TranspositionTable::newSearch() {
+    generation = (generation + 1) & 63;
+}
+
+bool TranspositionTable::probe(std::uint64_t key, TTData& out) const {
+    const Bucket& b = bucketFor(key);
+    for (const Entry& e : b.entries) {
+        std::uint64_t data = e.data.load(std::memory_order_relaxed);
+        std::uint64_t check = e.keyXorData.load(std::memory_order_relaxed);
+        if ((check ^ data) != key || boundOf(data) == Bound::None) continue;
+
+        out.move = unpackMove(data & 0xFFFF);
+        out.score = static_cast<std::int32_t>(static_cast<std::uint32_t>(data >> 16));
+        out.depth = depthOf(data);
+        out.bound = boundOf(data);
+        return true;
+    }
+    return false;
+}
+
+void TranspositionTable::store(std::uint64_t key, const Move& move, int score, int depth, Bound bound) {
+    Bucket& b = bucketFor(key);
+    Entry* replace = &b.entries[0];
+    int worst = 1 << 30;
+
+    for (Entry& e : b.entries) {
+        std::uint64_t data = e.data.load(std::memory_order_relaxed);
+        std::uint64_t check = e.keyXorData.load(std::memory_order_relaxed);
+        if ((check ^ data) == key) {
+            // Keep a deeper result for the same position unless this one is exact
+            if (bound != Bound::Exact && depth < depthOf(data) - 2 && generationOf(data) == generation) return;
+            // Keep the old best move when the new result has none
+            Move kept = move;
+            if (kept.startX < 0) kept = unpackMove(data & 0xFFFF);
+            std::uint64_t newData = pack(kept, score, depth, bound, generation);
+            e.data.store(newData, std::memory_order_relaxed);
+            e.keyXorData.store(key ^ newData, std::memory_order_relaxed);
+            return;
+        }
+        // Prefer to evict empty, then stale, then shallow entries
+        int age = (generation - generationOf(data)) & 63;
+        int value = (boundOf(data) == Bound::None) ? -1000 : depthOf(data) - 8 * age;
+        if (value < worst) {
+            worst = value;
+            replace = &e;
+        }
+    }
+
+    std::uint64_t newData = pack(move, score, depth, bound, generation);
+    replace->data.store(newData, std::memory_order_relaxed);
+    replace->keyXorData.store(key ^ newData, std::memory_order_relaxed);
+}
+
+int TranspositionTable::hashfull() const {
+    const std::size_t sample = buckets.size() < 250 ? buckets.size() : 250;
+    int used = 0;
+    for (std::size_t i = 0; i < sample; i++) {
+        for (const Entry& e : buckets[i].entries) {
+            std::uint64_t data = e.data.load(std::memory_order_relaxed);
+            if (boundOf(data) != Bound::None && generationOf(data) == generation) used++;
+        }
+    }
+    return sample ? static_cast<int>(used * 1000 / (sample * BucketSize)) : 0;
+}
@@ -0,0 +1,59 @@
+#ifndef TRANSPOSITIONTABLE_HPP
+#define TRANSPOSITIONTABLE_HPP
+
+#include "Move.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class Bound : std::uint8_t {
+    None, Exact, Lower, Upper
+};
+
+struct TTData {
+    Move move;
+    int score;
+    int depth;
+    Bound bound;
+};
+
+// Fixed-size hash table of search results, shared between search threads without
+// locks. Each slot stores its key XORed with its data, so a slot torn by two
+// concurrent writers fails verification on probe instead of returning garbage.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(std::size_t megabytes = 16);
+
+    void resize(std::size_t megabytes);
+    void clear();
+    // Starts a new search; entries from older searches are replaced first.
+    void newSearch();
+
+    bool probe(std::uint64_t key, TTData& out) const;
+    void store(std::uint64_t key, const Move& move, int score, int depth, Bound bound);
+
+    // Approximate fill rate in permille, from a sample of the table.
+    int hashfull() const;
+
+private:
+    struct Entry {
+        std::atomic<std::uint64_t> keyXorData{0};
+        std::atomic<std::uint64_t> data{0};
+    };
+
+    static constexpr int BucketSize = 4;
+
+    // One bucket per 64-byte cache line.
+    struct alignas(64) Bucket {
+        Entry entries[BucketSize];
+    };
+
+    std::vector<Bucket> buckets;
+    std::uint8_t generation = 0;
+
+    const Bucket& bucketFor(std::uint64_t key) const { return buckets[key & (buckets.size() - 1)]; }
+    Bucket& bucketFor(std::uint64_t key) { return buckets[key & (buckets.size() - 1)]; }
+};
+
+#endif
@@ -0,0 +1,48 @@
+#include "Zobrist.hpp"
+#include <mutex>
+
+namespace Zobrist {
+
+std::uint64_t pieceSquare[2][6][64];
+std::uint64_t castling[16];
+std::uint64_t enPassantFile[8];
+std::uint64_t blackToMove;
+
+namespace {
+
+// splitmix64, seeded with a constant so keys are stable between runs
+std::uint64_t nextKey(std::uint64_t& state) {
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+void initKeys() {
+    std::uint64_t state = 0x2545F4914F6CDD1DULL;
+    for (int c = 0; c < 2; c++)
+        for (int t = 0; t < 6; t++)
+            for (int sq = 0; sq < 64; sq++)
+                pieceSquare[c][t][sq] = nextKey(state);
+
+    // Each right gets its own key; a combination is the XOR of its rights
+    std::uint64_t rightKeys[4];
+    for (int i = 0; i < 4; i++) rightKeys[i] = nextKey(state);
+    for (int mask = 0; mask < 16; mask++) {
+        castling[mask] = 0;
+        for (int i = 0; i < 4; i++)
+            if (mask & (1 << i)) castling[mask] ^= rightKeys[i];
+    }
+
+    for (int f = 0; f < 8; f++) enPassantFile[f] = nextKey(state);
+    blackToMove = nextKey(state);
+}
+
+}
+
+void init() {
+    static std::once_flag flag;
+    std::call_once(flag, initKeys);
+}
+
+}
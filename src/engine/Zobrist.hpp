@@ -0,0 +1,19 @@
+#ifndef ZOBRIST_HPP
+#define ZOBRIST_HPP
+
+#include <cstdint>
+
+// Random keys XORed together to give each position a 64-bit identity.
+namespace Zobrist {
+
+extern std::uint64_t pieceSquare[2][6][64];
+extern std::uint64_t castling[16];
+extern std::uint64_t enPassantFile[8];
+extern std::uint64_t blackToMove;
+
+// Fills the key tables from a fixed seed. Safe to call more than once.
+void init();
+
+}
+
+#endif
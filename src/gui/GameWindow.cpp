@@ -1,198 +1,324 @@
-#include "GameWindow.hpp"
-#include <iostream>
-
-GameWindow::GameWindow() : window(sf::VideoMode(800, 800), "Ajedrez C++"), blackAI(PieceColor::Black) {
-    loadTextures();
-}
-
-void GameWindow::loadTextures() {
-    // For now, we will draw shapes if textures are missing, but let's define the paths.
-    // Piece names: wP, wN, wB, wR, wQ, wK, bP, bN, bB, bR, bQ, bK
-    std::string pieces[] = {"wP", "wN", "wB", "wR", "wQ", "wK", "bP", "bN", "bB", "bR", "bQ", "bK"};
-    std::string searchPaths[] = {"assets/", "../assets/", "./"};
-    
-    for (const std::string& p : pieces) {
-        sf::Texture tex;
-        bool loaded = false;
-        for (const std::string& path : searchPaths) {
-            std::string fullPath = path + p + ".png";
-            if (tex.loadFromFile(fullPath)) {
-                textures[p] = tex;
-                loaded = true;
-                std::cout << "Successfully loaded: " << fullPath << std::endl;
-                break;
-            }
-        }
-        if (!loaded) {
-            std::cerr << "Failed to find texture for: " << p << std::endl;
-        }
-    }
-
-    // Try to load a system font
-    std::string fonts[] = {
-        "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
-        "/usr/share/fonts/truetype/liberation/LiberationSans-Regular.ttf",
-        "/usr/share/fonts/truetype/freefont/FreeSans.ttf"
-    };
-    for (const std::string& f : fonts) {
-        if (font.loadFromFile(f)) {
-            fontLoaded = true;
-            break;
-        }
-    }
-}
-
-void GameWindow::run() {
-    while (window.isOpen()) {
-        processEvents();
-        update();
-        render();
-    }
-}
-
-void GameWindow::processEvents() {
-    sf::Event event;
-    while (window.pollEvent(event)) {
-        if (event.type == sf::Event::Closed)
-            window.close();
-        
-        if (event.type == sf::Event::MouseButtonPressed) {
-            if (event.mouseButton.button == sf::Mouse::Left) {
-                handleMouseClick(event.mouseButton.x, event.mouseButton.y);
-            }
-        }
-    }
-}
-
-void GameWindow::handleMouseClick(int x, int y) {
-    if (gameOver) return;
-
-    int gridX = x / 100;
-    int gridY = y / 100;
-
-    if (!pieceSelected) {
-        Piece p = board.getPiece(gridX, gridY);
-        if (p.type != PieceType::None && p.color == board.getTurn()) {
-            selectedX = gridX;
-            selectedY = gridY;
-            pieceSelected = true;
-        }
-    } else {
-        if (board.movePiece(selectedX, selectedY, gridX, gridY)) {
-            // Player moved, now AI moves
-            render(); // Show player move
-            
-            if (board.getTurn() == PieceColor::Black) {
-                if (board.isCheckmate(PieceColor::Black)) {
-                    gameOver = true;
-                    winner = PieceColor::White;
-                } else if (board.isStalemate(PieceColor::Black)) {
-                    gameOver = true;
-                    isStalemate = true;
-                } else {
-                    Move aiMove = blackAI.getBestMove(board, 3);
-                    if (aiMove.startX != -1) {
-                        board.movePiece(aiMove.startX, aiMove.startY, aiMove.endX, aiMove.endY);
-                        // Check after AI move
-                        if (board.isCheckmate(PieceColor::White)) {
-                            gameOver = true;
-                            winner = PieceColor::Black;
-                        } else if (board.isStalemate(PieceColor::White)) {
-                            gameOver = true;
-                            isStalemate = true;
-                        }
-                    }
-                }
-            }
-        }
-        pieceSelected = false;
-    }
-}
-
-void GameWindow::update() {}
-
-void GameWindow::render() {
-    window.clear();
-
-    // Draw board
-    sf::RectangleShape square(sf::Vector2f(100.0f, 100.0f));
-    for (int i = 0; i < 8; i++) {
-        for (int j = 0; j < 8; j++) {
-            if ((i + j) % 2 == 0) square.setFillColor(sf::Color(255, 206, 158));
-            else square.setFillColor(sf::Color(209, 139, 71));
-            
-            if (pieceSelected && i == selectedX && j == selectedY) {
-                square.setFillColor(sf::Color(130, 150, 105)); // Highlight selected
-            }
-
-            square.setPosition(i * 100, j * 100);
-            window.draw(square);
-
-            Piece p = board.getPiece(i, j);
-            if (p.type != PieceType::None) {
-                // If texture exists, draw it. Otherwise draw a circle/square as placeholder.
-                std::string code = (p.color == PieceColor::White ? "w" : "b");
-                switch(p.type) {
-                    case PieceType::Pawn: code += "P"; break;
-                    case PieceType::Knight: code += "N"; break;
-                    case PieceType::Bishop: code += "B"; break;
-                    case PieceType::Rook: code += "R"; break;
-                    case PieceType::Queen: code += "Q"; break;
-                    case PieceType::King: code += "K"; break;
-                    default: break;
-                }
-
-                if (textures.count(code)) {
-                    sf::Sprite sprite(textures[code]);
-                    sprite.setPosition(i * 100, j * 100);
-                    // Scale from 140x140 to 100x100
-                    sprite.setScale(100.0f / 140.0f, 100.0f / 140.0f);
-                    window.draw(sprite);
-                } else {
-                    sf::CircleShape circ(40);
-                    circ.setFillColor(p.color == PieceColor::White ? sf::Color::White : sf::Color::Black);
-                    circ.setOutlineThickness(2);
-                    circ.setOutlineColor(sf::Color::Red);
-                    circ.setPosition(i * 100 + 10, j * 100 + 10);
-                    window.draw(circ);
-                    
-                    if (fontLoaded) {
-                        sf::Text text;
-                        text.setFont(font);
-                        std::string label = code.substr(1);
-                        text.setString(label);
-                        text.setCharacterSize(40);
-                        text.setFillColor(p.color == PieceColor::White ? sf::Color::Black : sf::Color::White);
-                        // Center text
-                        sf::FloatRect textRect = text.getLocalBounds();
-                        text.setOrigin(textRect.left + textRect.width/2.0f, textRect.top  + textRect.height/2.0f);
-                        text.setPosition(sf::Vector2f(i * 100 + 50, j * 100 + 50));
-                        window.draw(text);
-                    }
-                }
-            }
-        }
-    }
-
-    if (gameOver && fontLoaded) {
-        sf::RectangleShape overlay(sf::Vector2f(800.0f, 800.0f));
-        overlay.setFillColor(sf::Color(0, 0, 0, 150));
-        window.draw(overlay);
-
-        sf::Text text;
-        text.setFont(font);
-        if (isStalemate) {
-            text.setString("STALEMATE!");
-        } else {
-            text.setString(winner == PieceColor::White ? "WHITE WINS!" : "BLACK WINS!");
-        }
-        text.setCharacterSize(80);
-        text.setFillColor(sf::Color::White);
-        sf::FloatRect textRect = text.getLocalBounds();
-        text.setOrigin(textRect.left + textRect.width/2.0f, textRect.top  + textRect.height/2.0f);
-        text.setPosition(sf::Vector2f(400, 400));
-        window.draw(text);
-    }
-
-    window.display();
-}
+#include "GameWindow.hpp"
+#include "Bitbases.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <thread>
+#include <iostream>
+
+// Thinking time per AI move
+const int AI_MOVE_TIME_MS = 1000;
+// While the AI thinks the loop waits this long for its move before looking at
+// input again; otherwise it sleeps until the next event
+const int AI_POLL_MS = 10;
+const float SQUARE_SIZE = 100.0f;
+
+namespace {
+
+const sf::Color LIGHT_SQUARE(255, 206, 158);
+const sf::Color DARK_SQUARE(209, 139, 71);
+const sf::Color SELECTED_SQUARE(130, 150, 105);
+
+// Corners of a quad in the order sf::Quads expects
+void setQuad(sf::Vertex* quad, float x, float y, float size) {
+    quad[0].position = sf::Vector2f(x, y);
+    quad[1].position = sf::Vector2f(x + size, y);
+    quad[2].position = sf::Vector2f(x + size, y + size);
+    quad[3].position = sf::Vector2f(x, y + size);
+}
+
+}
+
+GameWindow::GameWindow(const GameSettings& settings)
+    : window(sf::VideoMode(800, 800), "Ajedrez C++"), settings(settings), blackAI(PieceColor::Black) {
+    blackAI.setThreads(std::max(1, settings.threads));
+    // Only caps redraws during bursts of events; an idle window draws nothing
+    window.setFramerateLimit(60);
+    loadTextures();
+
+    squareVertices.setPrimitiveType(sf::Quads);
+    squareVertices.resize(64 * 4);
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 8; x++) setQuad(&squareVertices[(y * 8 + x) * 4], x * SQUARE_SIZE, y * SQUARE_SIZE, SQUARE_SIZE);
+    }
+    pieceVertices.setPrimitiveType(sf::Quads);
+
+    // Opening book is optional; without it the AI searches from the first move
+    std::string bookPaths[] = {"assets/book.bin", "../assets/book.bin", "book.bin"};
+    for (const std::string& path : bookPaths) {
+        if (blackAI.loadBook(path)) {
+            std::cout << "Opening book: " << path << std::endl;
+            break;
+        }
+    }
+
+    // Built on the first run, on every core since it only happens once, and
+    // mapped from disk afterwards
+    Bitbases::init("bitbases", std::max(1u, std::thread::hardware_concurrency()));
+}
+
+void GameWindow::loadTextures() {
+    // For now, we will draw shapes if textures are missing, but let's define the paths.
+    // Piece names: wP, wN, wB, wR, wQ, wK, bP, bN, bB, bR, bQ, bK
+    std::string pieces[] = {"wP", "wN", "wB", "wR", "wQ", "wK", "bP", "bN", "bB", "bR", "bQ", "bK"};
+    std::string searchPaths[] = {"assets/", "../assets/", "./"};
+    
+    // The images are packed into one atlas in the order above, which is the
+    // colorIndex * 6 + typeIndex order, so a single texture serves every piece
+    sf::Image images[12];
+    unsigned cell = 0;
+    for (int i = 0; i < 12; i++) {
+        for (const std::string& path : searchPaths) {
+            std::string fullPath = path + pieces[i] + ".png";
+            if (images[i].loadFromFile(fullPath)) {
+                hasTexture[i] = true;
+                cell = std::max({cell, images[i].getSize().x, images[i].getSize().y});
+                std::cout << "Successfully loaded: " << fullPath << std::endl;
+                break;
+            }
+        }
+        if (!hasTexture[i]) {
+            std::cerr << "Failed to find texture for: " << pieces[i] << std::endl;
+        }
+    }
+
+    sf::Image sheet;
+    sheet.create(12 * cell, cell, sf::Color::Transparent);
+    for (int i = 0; i < 12; i++) {
+        if (hasTexture[i]) sheet.copy(images[i], i * cell, 0);
+    }
+    if (cell > 0 && atlas.loadFromImage(sheet)) {
+        atlas.setSmooth(true);
+        atlasCell = static_cast<float>(cell);
+    } else {
+        std::fill(std::begin(hasTexture), std::end(hasTexture), false);
+    }
+
+    // Try to load a system font
+    std::string fonts[] = {
+        "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
+        "/usr/share/fonts/truetype/liberation/LiberationSans-Regular.ttf",
+        "/usr/share/fonts/truetype/freefont/FreeSans.ttf"
+    };
+    for (const std::string& f : fonts) {
+        if (font.loadFromFile(f)) {
+            fontLoaded = true;
+            break;
+        }
+    }
+}
+
+void GameWindow::run() {
+    while (window.isOpen()) {
+        if (aiThinking) {
+            // update() blocks for up to AI_POLL_MS waiting for the AI's move
+            processEvents();
+            update();
+        } else {
+            // Nothing changes until the player does something; pondering, if
+            // enabled, only ends on a player move
+            sf::Event event;
+            if (window.waitEvent(event)) handleEvent(event);
+            processEvents();
+        }
+
+        if (needsRedraw && window.isOpen()) {
+            render();
+            needsRedraw = false;
+        }
+    }
+}
+
+void GameWindow::processEvents() {
+    sf::Event event;
+    while (window.pollEvent(event)) handleEvent(event);
+}
+
+void GameWindow::handleEvent(const sf::Event& event) {
+    if (event.type == sf::Event::Closed)
+        window.close();
+
+    // The window contents may have been lost or stretched
+    if (event.type == sf::Event::Resized || event.type == sf::Event::GainedFocus || event.type == sf::Event::MouseEntered)
+        needsRedraw = true;
+
+    if (event.type == sf::Event::MouseButtonPressed) {
+        if (event.mouseButton.button == sf::Mouse::Left) {
+            handleMouseClick(event.mouseButton.x, event.mouseButton.y);
+        }
+    }
+}
+
+void GameWindow::handleMouseClick(int x, int y) {
+    if (gameOver || aiThinking) return;
+
+    int gridX = x / 100;
+    int gridY = y / 100;
+    needsRedraw = true;
+
+    if (!pieceSelected) {
+        Piece p = board.getPiece(gridX, gridY);
+        if (p.type != PieceType::None && p.color == board.getTurn()) {
+            selectedX = gridX;
+            selectedY = gridY;
+            pieceSelected = true;
+        }
+    } else {
+        if (board.movePiece(selectedX, selectedY, gridX, gridY)) {
+            // Player moved, now AI moves
+            Move played = {selectedX, selectedY, gridX, gridY, 0};
+            if (board.getTurn() == PieceColor::Black) {
+                if (board.isCheckmate(PieceColor::Black)) {
+                    gameOver = true;
+                    winner = PieceColor::White;
+                } else if (board.isStalemate(PieceColor::Black)) {
+                    gameOver = true;
+                    isStalemate = true;
+                } else {
+                    startAIMove(played);
+                }
+            }
+            if (gameOver && pondering) {
+                blackAI.stop();
+                pondering = false;
+            }
+        }
+        pieceSelected = false;
+    }
+}
+
+void GameWindow::startAIMove(const Move& played) {
+    bool ponderHit = pondering && played.sameSquares(ponderMove) &&
+                     (ponderMove.promotion == PieceType::None || ponderMove.promotion == PieceType::Queen);
+    if (ponderHit) {
+        // The search already running on this position keeps its work
+        blackAI.ponderHit();
+    } else {
+        SearchLimits limits;
+        limits.moveTime = AI_MOVE_TIME_MS;
+        aiSearch = blackAI.searchAsync(board, limits);
+    }
+    pondering = false;
+    aiThinking = true;
+}
+
+void GameWindow::startPondering(const Move& expectedReply) {
+    Board ponderBoard = board;
+    if (!ponderBoard.movePiece(expectedReply.startX, expectedReply.startY, expectedReply.endX, expectedReply.endY,
+                               expectedReply.promotion)) return;
+    if (!ponderBoard.hasLegalMoves(ponderBoard.getTurn())) return;
+
+    SearchLimits limits;
+    limits.moveTime = AI_MOVE_TIME_MS;
+    limits.ponder = true;
+    aiSearch = blackAI.searchAsync(ponderBoard, limits);
+    ponderMove = expectedReply;
+    pondering = true;
+}
+
+void GameWindow::update() {
+    if (!aiThinking || !aiSearch.valid()) return;
+    if (aiSearch.wait_for(std::chrono::milliseconds(AI_POLL_MS)) != std::future_status::ready) return;
+
+    SearchResult result = aiSearch.get();
+    aiThinking = false;
+    needsRedraw = true;
+    Move aiMove = result.bestMove;
+    if (aiMove.startX == -1) return;
+
+    board.movePiece(aiMove.startX, aiMove.startY, aiMove.endX, aiMove.endY, aiMove.promotion);
+    // Check after AI move
+    if (board.isCheckmate(PieceColor::White)) {
+        gameOver = true;
+        winner = PieceColor::Black;
+    } else if (board.isStalemate(PieceColor::White)) {
+        gameOver = true;
+        isStalemate = true;
+    } else if (settings.ponder && result.pv.size() >= 2) {
+        startPondering(result.pv[1]);
+    }
+}
+
+void GameWindow::render() {
+    window.clear();
+
+    // One quad per square and one per piece; only pieces without an image fall
+    // back to shapes drawn one by one
+    pieceVertices.clear();
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 8; x++) {
+            sf::Color color = (x + y) % 2 == 0 ? LIGHT_SQUARE : DARK_SQUARE;
+            if (pieceSelected && x == selectedX && y == selectedY) color = SELECTED_SQUARE;
+            sf::Vertex* quad = &squareVertices[(y * 8 + x) * 4];
+            for (int k = 0; k < 4; k++) quad[k].color = color;
+
+            Piece p = board.getPiece(x, y);
+            if (p.type == PieceType::None) continue;
+            const int slot = colorIndex(p.color) * 6 + typeIndex(p.type);
+            if (!hasTexture[slot]) continue;
+
+            sf::Vertex corners[4];
+            setQuad(corners, x * SQUARE_SIZE, y * SQUARE_SIZE, SQUARE_SIZE);
+            const float left = slot * atlasCell;
+            corners[0].texCoords = sf::Vector2f(left, 0);
+            corners[1].texCoords = sf::Vector2f(left + atlasCell, 0);
+            corners[2].texCoords = sf::Vector2f(left + atlasCell, atlasCell);
+            corners[3].texCoords = sf::Vector2f(left, atlasCell);
+            for (const sf::Vertex& v : corners) pieceVertices.append(v);
+        }
+    }
+    window.draw(squareVertices);
+    window.draw(pieceVertices, sf::RenderStates(&atlas));
+
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 8; x++) {
+            Piece p = board.getPiece(x, y);
+            if (p.type != PieceType::None && !hasTexture[colorIndex(p.color) * 6 + typeIndex(p.type)]) drawPlaceholder(x, y, p);
+        }
+    }
+
+    if (gameOver && fontLoaded) {
+        sf::RectangleShape overlay(sf::Vector2f(800.0f, 800.0f));
+        overlay.setFillColor(sf::Color(0, 0, 0, 150));
+        window.draw(overlay);
+
+        sf::Text text;
+        text.setFont(font);
+        if (isStalemate) {
+            text.setString("STALEMATE!");
+        } else {
+            text.setString(winner == PieceColor::White ? "WHITE WINS!" : "BLACK WINS!");
+        }
+        text.setCharacterSize(80);
+        text.setFillColor(sf::Color::White);
+        sf::FloatRect textRect = text.getLocalBounds();
+        text.setOrigin(textRect.left + textRect.width/2.0f, textRect.top  + textRect.height/2.0f);
+        text.setPosition(sf::Vector2f(400, 400));
+        window.draw(text);
+    }
+
+    window.display();
+}
+
+void GameWindow::drawPlaceholder(int x, int y, Piece p) {
+    const char letters[] = "PNBRQK";
+    sf::CircleShape circ(40);
+    circ.setFillColor(p.color == PieceColor::White ? sf::Color::White : sf::Color::Black);
+    circ.setOutlineThickness(2);
+    circ.setOutlineColor(sf::Color::Red);
+    circ.setPosition(x * 100 + 10, y * 100 + 10);
+    window.draw(circ);
+
+    if (fontLoaded) {
+        sf::Text text;
+        text.setFont(font);
+        text.setString(std::string(1, letters[typeIndex(p.type)]));
+        text.setCharacterSize(40);
+        text.setFillColor(p.color == PieceColor::White ? sf::Color::Black : sf::Color::White);
+        // Center text
+        sf::FloatRect textRect = text.getLocalBounds();
+        text.setOrigin(textRect.left + textRect.width/2.0f, textRect.top  + textRect.height/2.0f);
+        text.setPosition(sf::Vector2f(x * 100 + 50, y * 100 + 50));
+        window.draw(text);
+    }
+}
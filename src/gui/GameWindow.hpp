@@ -1,38 +1,64 @@
-#ifndef GAMEWINDOW_HPP
-#define GAMEWINDOW_HPP
-
-#include <SFML/Graphics.hpp>
-#include "Board.hpp"
-#include "AI.hpp"
-#include <map>
-
-class GameWindow {
-public:
-    GameWindow();
-    void run();
-
-private:
-    void processEvents();
-    void update();
-    void render();
-    void loadTextures();
-    void handleMouseClick(int x, int y);
-
-    sf::RenderWindow window;
-    Board board;
-    std::map<std::string, sf::Texture> textures;
-    sf::Font font;
-    bool fontLoaded = false;
-    
-    int selectedX = -1;
-    int selectedY = -1;
-    bool pieceSelected = false;
-    
-    bool gameOver = false;
-    bool isStalemate = false;
-    PieceColor winner = PieceColor::None;
-    
-    AI blackAI;
-};
-
-#endif
+#ifndef GAMEWINDOW_HPP
+#define GAMEWINDOW_HPP
+
+#include <SFML/Graphics.hpp>
+#include "Board.hpp"
+#include "AI.hpp"
+#include <future>
+
+// Chosen on the command line
+struct GameSettings {
+    // Keep searching on the expected reply while the player thinks; this keeps
+    // the CPU busy between moves, so it is off unless asked for
+    bool ponder = false;
+    // Search threads for the AI; a desktop game does not need every core
+    int threads = 1;
+};
+
+class GameWindow {
+public:
+    explicit GameWindow(const GameSettings& settings = GameSettings());
+    void run();
+
+private:
+    void processEvents();
+    void handleEvent(const sf::Event& event);
+    void update();
+    void render();
+    void loadTextures();
+    void drawPlaceholder(int x, int y, Piece p);
+    void handleMouseClick(int x, int y);
+    void startAIMove(const Move& played);
+    void startPondering(const Move& expectedReply);
+
+    sf::RenderWindow window;
+    Board board;
+    // All twelve piece images side by side, slot colorIndex * 6 + typeIndex
+    sf::Texture atlas;
+    float atlasCell = 0;
+    bool hasTexture[12] = {};
+    // The squares and the pieces, each drawn in a single call
+    sf::VertexArray squareVertices;
+    sf::VertexArray pieceVertices;
+    // Set by anything that changes what is on screen; nothing is drawn otherwise
+    bool needsRedraw = true;
+    sf::Font font;
+    bool fontLoaded = false;
+    
+    int selectedX = -1;
+    int selectedY = -1;
+    bool pieceSelected = false;
+    
+    bool gameOver = false;
+    bool isStalemate = false;
+    PieceColor winner = PieceColor::None;
+    
+    GameSettings settings;
+    AI blackAI;
+    std::future<SearchResult> aiSearch;
+    bool aiThinking = false;
+    bool pondering = false;
+    Move ponderMove = {-1, -1, -1, -1, 0};
+};
+
+#endif
@@ -0,0 +1,205 @@
+#include "UciEngine.hpp"
+#include "Bitbases.hpp"
+#include "Nnue.hpp"
+#include "Notation.hpp"
+#include <cstdlib>
+
+namespace {
+
+const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+std::string scoreToUci(int score) {
+    if (score > MATE_BOUND) return "mate " + std::to_string((MATE_SCORE - score + 1) / 2);
+    if (score < -MATE_BOUND) return "mate -" + std::to_string((MATE_SCORE + score) / 2);
+    return "cp " + std::to_string(score);
+}
+
+}
+
+UciEngine::UciEngine(std::istream& in, std::ostream& out) : in(in), out(out), ai(PieceColor::White) {
+    ai.setInfoCallback([this](const SearchResult& info) { sendInfo(info); });
+}
+
+UciEngine::~UciEngine() {
+    handleStop();
+    waitForSearch();
+}
+
+void UciEngine::run() {
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream args(line);
+        std::string command;
+        if (!(args >> command)) continue;
+
+        if (command == "uci") handleUci();
+        else if (command == "isready") {
+            // Building missing bitbases takes a moment, which isready is allowed to
+            loadBitbases();
+            send("readyok");
+        }
+        else if (command == "ucinewgame") {
+            waitForSearch();
+            ai.clearHash();
+        }
+        else if (command == "setoption") handleSetOption(args);
+        else if (command == "position") handlePosition(args);
+        else if (command == "go") handleGo(args);
+        else if (command == "stop") handleStop();
+        else if (command == "ponderhit") handlePonderHit();
+        else if (command == "quit") break;
+    }
+}
+
+void UciEngine::handleUci() {
+    send("id name Ajedrez");
+    send("id author Ajedrez developers");
+    send("option name Hash type spin default 16 min 1 max 4096");
+    send("option name Threads type spin default 1 min 1 max 256");
+    send("option name Ponder type check default false");
+    send("option name Clear Hash type button");
+    send("option name BookFile type string default <empty>");
+    send("option name BitbasePath type string default " + bitbasePath);
+    send("option name EvalFile type string default <empty>");
+    send("option name Use NNUE type check default false");
+    send("uciok");
+}
+
+void UciEngine::handleSetOption(std::istringstream& args) {
+    // setoption name <name, may contain spaces> [value <value>]
+    std::string token, name, value;
+    args >> token;
+    while (args >> token && token != "value") name += (name.empty() ? "" : " ") + token;
+    std::getline(args >> std::ws, value);
+
+    waitForSearch();
+    if (name == "Hash") ai.setHashSize(std::atoi(value.c_str()));
+    else if (name == "Threads") ai.setThreads(std::atoi(value.c_str()));
+    else if (name == "Clear Hash") ai.clearHash();
+    else if (name == "BookFile") {
+        if (value.empty() || value == "<empty>") ai.closeBook();
+        else if (!ai.loadBook(value)) send("info string cannot open book " + value);
+    }
+    else if (name == "BitbasePath" && !value.empty()) bitbasePath = value;
+    else if (name == "EvalFile") {
+        if (value.empty() || value == "<empty>") Nnue::unload();
+        else if (Nnue::load(value)) send("info string NNUE network " + value + " (" + Nnue::kernelName(Nnue::kernel()) + ")");
+        else send("info string cannot load NNUE network " + value);
+    }
+    else if (name == "Use NNUE") ai.setUseNnue(value == "true");
+}
+
+void UciEngine::loadBitbases() {
+    if (Bitbases::isLoaded()) return;
+    if (!Bitbases::init(bitbasePath, ai.getThreads())) send("info string cannot load bitbases from " + bitbasePath);
+}
+
+void UciEngine::handlePosition(std::istringstream& args) {
+    std::string token, fen;
+    args >> token;
+    if (token == "startpos") {
+        fen = START_FEN;
+        args >> token;
+    } else if (token == "fen") {
+        while (args >> token && token != "moves") fen += token + " ";
+    } else {
+        return;
+    }
+
+    waitForSearch();
+    Board parsed;
+    if (!parsed.fromFEN(fen)) {
+        send("info string invalid fen " + fen);
+        return;
+    }
+    if (token == "moves") {
+        while (args >> token) {
+            Move m;
+            if (!parseUciMove(parsed, token, m)) {
+                send("info string illegal move " + token);
+                break;
+            }
+            parsed.makeMove(m);
+        }
+    }
+    board = parsed;
+}
+
+void UciEngine::handleGo(std::istringstream& args) {
+    SearchLimits limits;
+    std::string token;
+    while (args >> token) {
+        if (token == "depth") args >> limits.depth;
+        else if (token == "movetime") args >> limits.moveTime;
+        else if (token == "wtime") args >> limits.whiteTime;
+        else if (token == "btime") args >> limits.blackTime;
+        else if (token == "winc") args >> limits.whiteIncrement;
+        else if (token == "binc") args >> limits.blackIncrement;
+        else if (token == "movestogo") args >> limits.movesToGo;
+        else if (token == "nodes") args >> limits.nodes;
+        else if (token == "infinite") limits.infinite = true;
+        else if (token == "ponder") limits.ponder = true;
+    }
+
+    waitForSearch();
+    loadBitbases();
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopReceived = false;
+        holdBestMove = limits.infinite || limits.ponder;
+    }
+    // searchAsync resets the stop and ponder flags before it returns, so a stop
+    // or ponderhit read right after this is not lost
+    searchThread = std::thread(&UciEngine::searchLoop, this, ai.searchAsync(board, limits));
+}
+
+void UciEngine::searchLoop(std::future<SearchResult> search) {
+    SearchResult result = search.get();
+
+    // A search that ends on its own during "go infinite" or pondering keeps its
+    // answer until the GUI asks for it
+    {
+        std::unique_lock<std::mutex> lock(stateMutex);
+        stateChanged.wait(lock, [this] { return stopReceived || !holdBestMove; });
+    }
+
+    std::string line = "bestmove " + moveToUci(result.bestMove);
+    if (result.pv.size() >= 2) line += " ponder " + moveToUci(result.pv[1]);
+    send(line);
+}
+
+void UciEngine::handleStop() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopReceived = true;
+    }
+    stateChanged.notify_all();
+    ai.stop();
+}
+
+void UciEngine::handlePonderHit() {
+    ai.ponderHit();
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        holdBestMove = false;
+    }
+    stateChanged.notify_all();
+}
+
+void UciEngine::waitForSearch() {
+    if (searchThread.joinable()) searchThread.join();
+}
+
+void UciEngine::sendInfo(const SearchResult& info) {
+    std::ostringstream line;
+    std::uint64_t nps = info.timeMs > 0 ? info.nodes * 1000 / info.timeMs : info.nodes;
+    line << "info depth " << info.depth << " score " << scoreToUci(info.score) << " nodes " << info.nodes
+         << " nps " << nps << " hashfull " << ai.hashfull() << " time " << info.timeMs << " pv";
+    for (const Move& m : info.pv) line << " " << moveToUci(m);
+    send(line.str());
+}
+
+void UciEngine::send(const std::string& line) {
+    std::lock_guard<std::mutex> lock(outMutex);
+    out << line << std::endl;
+}
@@ -0,0 +1,54 @@
+#ifndef UCIENGINE_HPP
+#define UCIENGINE_HPP
+
+#include "Board.hpp"
+#include "AI.hpp"
+#include <condition_variable>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+// Universal Chess Interface front end: reads commands from an input stream and
+// answers on an output stream. Searches run on their own thread so that "stop"
+// and "ponderhit" are handled while the engine is thinking.
+class UciEngine {
+public:
+    UciEngine(std::istream& in, std::ostream& out);
+    ~UciEngine();
+    void run();
+
+private:
+    void handleUci();
+    void handleSetOption(std::istringstream& args);
+    void handlePosition(std::istringstream& args);
+    void handleGo(std::istringstream& args);
+    void handleStop();
+    void handlePonderHit();
+    void loadBitbases();
+    void waitForSearch();
+    void searchLoop(std::future<SearchResult> search);
+    void sendInfo(const SearchResult& info);
+    void send(const std::string& line);
+
+    std::istream& in;
+    std::ostream& out;
+    std::mutex outMutex;
+
+    Board board;
+    AI ai;
+    // Waits for the AI's search and sends bestmove
+    std::thread searchThread;
+    // Read on the first isready or go; changing it later has no effect
+    std::string bitbasePath = "bitbases";
+
+    // bestmove may only be sent after "stop" or "ponderhit" for infinite and ponder searches
+    std::mutex stateMutex;
+    std::condition_variable stateChanged;
+    bool stopReceived = false;
+    bool holdBestMove = false;
+};
+
+#endif
@@ -0,0 +1,284 @@
+#include "AI.hpp"
+#include "Epd.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::string input;    // empty or "-" for stdin
+    std::string output;   // empty for stdout
+    int depth = 0;
+    std::uint64_t nodes = 0;
+    int moveTime = 0;
+    int threads = 1;
+    int hashMB = 16;
+    int readAhead = 0;    // 0: 8 per thread
+};
+
+struct Job {
+    std::uint64_t seq;
+    int lineNumber;
+    std::string line;
+};
+
+void printUsage() {
+    std::cout << "Usage: analyze [file] [options]\n"
+              << "Reads FEN or EPD lines from file (or stdin) and writes one JSON line per position,\n"
+              << "in input order.\n"
+              << "  --depth N       depth limit per position\n"
+              << "  --nodes N       node limit per position\n"
+              << "  --movetime MS   time limit per position\n"
+              << "  --threads N     positions searched in parallel, one search thread each (default 1)\n"
+              << "  --hash MB       transposition table size per worker (default 16)\n"
+              << "  --read-ahead N  positions read ahead of the output (default 8 per thread)\n"
+              << "  --output FILE   write the results to FILE instead of stdout\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--depth" && hasValue) opt.depth = std::atoi(argv[++i]);
+        else if (arg == "--nodes" && hasValue) opt.nodes = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--movetime" && hasValue) opt.moveTime = std::atoi(argv[++i]);
+        else if (arg == "--threads" && hasValue) opt.threads = std::atoi(argv[++i]);
+        else if (arg == "--hash" && hasValue) opt.hashMB = std::atoi(argv[++i]);
+        else if (arg == "--read-ahead" && hasValue) opt.readAhead = std::atoi(argv[++i]);
+        else if (arg == "--output" && hasValue) opt.output = argv[++i];
+        else if ((arg == "-" || arg[0] != '-') && opt.input.empty()) opt.input = arg;
+        else return false;
+    }
+    if (opt.readAhead == 0) opt.readAhead = 8 * opt.threads;
+    return opt.threads > 0 && opt.hashMB > 0 && opt.readAhead > 0 && (opt.depth > 0 || opt.nodes > 0 || opt.moveTime > 0);
+}
+
+std::string analyzeLine(AI& ai, const Job& job, const SearchLimits& limits, std::uint64_t& nodes) {
+    // A FEN, or an EPD record of which only the id operation is kept
+    Board board;
+    EpdRecord record;
+    std::ostringstream out;
+    out << "{\"line\":" << job.lineNumber;
+    if (!parseEpdLine(job.line, record) || !board.fromFEN(record.fen)) {
+        out << ",\"fen\":" << jsonString(job.line) << ",\"error\":\"invalid position\"}";
+        return out.str();
+    }
+    const std::string id = record.id();
+    if (!id.empty()) out << ",\"id\":" << jsonString(id);
+    out << ",\"fen\":" << jsonString(record.fen);
+
+    // A fresh table for every position, so a result does not depend on which
+    // worker searched it or what it searched before
+    ai.clearHash();
+    SearchResult result = ai.search(board, limits);
+    nodes = result.nodes;
+    out << ",\"search\":" << toJson(result) << "}";
+    return out.str();
+}
+
+// Work-stealing job queues: one per worker, filled round-robin by the reader.
+// A worker takes jobs from the front of its own queue and, once that is empty,
+// from the back of the others', so a worker stuck on slow positions does not
+// hold up jobs that another worker could search.
+class WorkStealingQueues {
+public:
+    explicit WorkStealingQueues(int workers) : queues(workers) {}
+
+    void push(Job job) {
+        Queue& q = queues[nextQueue++ % queues.size()];
+        {
+            std::lock_guard<std::mutex> lock(q.mutex);
+            q.jobs.push_back(std::move(job));
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            pending++;
+        }
+        wake.notify_one();
+    }
+
+    // No more jobs will be pushed; idle workers return once the queues are empty
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            closed = true;
+        }
+        wake.notify_all();
+    }
+
+    // Blocks until there is a job for worker self; false when closed and empty
+    bool pop(int self, Job& job) {
+        for (;;) {
+            if (take(self, job)) return true;
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [&] { return pending > 0 || closed; });
+            if (pending == 0 && closed) return false;
+        }
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    bool take(int self, Job& job) {
+        const int n = static_cast<int>(queues.size());
+        for (int i = 0; i < n; i++) {
+            Queue& q = queues[(self + i) % n];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (q.jobs.empty()) continue;
+            if (i == 0) {
+                job = std::move(q.jobs.front());
+                q.jobs.pop_front();
+            } else {
+                job = std::move(q.jobs.back());
+                q.jobs.pop_back();
+            }
+            std::lock_guard<std::mutex> sleepLock(sleepMutex);
+            pending--;
+            return true;
+        }
+        return false;
+    }
+
+    std::vector<Queue> queues;
+    std::size_t nextQueue = 0;   // only the reader pushes
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::size_t pending = 0;
+    bool closed = false;
+};
+
+// Puts finished results back in input order. At most window jobs are between
+// being read and being written, which bounds the memory used by the queues
+// and by results waiting for a slower earlier position.
+class OrderedWriter {
+public:
+    OrderedWriter(std::ostream& out, std::size_t window) : out(out), slots(window), ready(window, false) {}
+
+    // Blocks the reader until job seq fits in the window
+    void reserve(std::uint64_t seq) {
+        std::unique_lock<std::mutex> lock(mutex);
+        written.wait(lock, [&] { return seq < nextToWrite + slots.size(); });
+    }
+
+    void complete(std::uint64_t seq, std::string result) {
+        std::lock_guard<std::mutex> lock(mutex);
+        slots[seq % slots.size()] = std::move(result);
+        ready[seq % slots.size()] = true;
+        bool any = false;
+        while (ready[nextToWrite % slots.size()]) {
+            std::size_t slot = nextToWrite % slots.size();
+            out << slots[slot] << "\n";
+            slots[slot].clear();
+            slots[slot].shrink_to_fit();
+            ready[slot] = false;
+            nextToWrite++;
+            any = true;
+        }
+        if (any) {
+            out.flush();
+            written.notify_all();
+        }
+    }
+
+private:
+    std::ostream& out;
+    std::vector<std::string> slots;
+    std::vector<bool> ready;
+    std::uint64_t nextToWrite = 0;
+    std::mutex mutex;
+    std::condition_variable written;
+};
+
+}
+
+int main(int argc, char* argv[]) {
+    std::ios::sync_with_stdio(false);
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) {
+        printUsage();
+        return 2;
+    }
+
+    std::ifstream file;
+    if (!opt.input.empty() && opt.input != "-") {
+        file.open(opt.input);
+        if (!file) {
+            std::cerr << "Cannot open " << opt.input << "\n";
+            return 1;
+        }
+    }
+    std::istream& in = file.is_open() ? file : std::cin;
+    // Reading std::cin flushes std::cout first; that would race with the workers
+    std::cin.tie(nullptr);
+    std::ofstream outFile;
+    if (!opt.output.empty()) {
+        outFile.open(opt.output);
+        if (!outFile) {
+            std::cerr << "Cannot write " << opt.output << "\n";
+            return 1;
+        }
+    }
+    std::ostream& out = outFile.is_open() ? outFile : std::cout;
+
+    SearchLimits limits;
+    limits.depth = opt.depth;
+    limits.nodes = opt.nodes;
+    limits.moveTime = opt.moveTime;
+
+    WorkStealingQueues queues(opt.threads);
+    OrderedWriter writer(out, opt.readAhead);
+    std::atomic<std::uint64_t> totalNodes{0};
+
+    auto worker = [&](int id) {
+        AI ai(PieceColor::White);
+        ai.setHashSize(opt.hashMB);
+        Job job;
+        while (queues.pop(id, job)) {
+            std::uint64_t nodes = 0;
+            std::string result = analyzeLine(ai, job, limits, nodes);
+            totalNodes += nodes;
+            writer.complete(job.seq, std::move(result));
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int i = 0; i < opt.threads; i++) workers.emplace_back(worker, i);
+
+    std::uint64_t seq = 0;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        if (isEpdComment(line)) continue;
+        writer.reserve(seq);
+        queues.push({seq++, lineNumber, line});
+    }
+    queues.close();
+    for (std::thread& w : workers) w.join();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Positions: " << seq << "\n"
+              << "Nodes: " << totalNodes << "\n"
+              << "Time: " << static_cast<long long>(seconds * 1000) << " ms\n"
+              << "NPS: " << static_cast<std::uint64_t>(seconds > 0 ? totalNodes / seconds : 0) << "\n";
+    if (!out) {
+        std::cerr << "Write error\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,326 @@
+#include "AI.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Every heap allocation in the process goes through these, so a benchmark can
+// report how many allocations one operation makes.
+namespace {
+std::atomic<std::uint64_t> allocationCount{0};
+}
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+// Over-aligned types (Board is alignas(32)) come through these instead
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    const std::size_t align = static_cast<std::size_t>(alignment);
+    // aligned_alloc wants a size that is a multiple of the alignment
+    if (void* p = std::aligned_alloc(align, (std::max<std::size_t>(size, 1) + align - 1) / align * align)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) { return operator new(size, alignment); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+namespace {
+
+// Middlegame and endgame positions; changing them invalidates earlier results.
+const char* corpus[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 0 8",
+    "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1",
+    "2r3k1/pp3ppp/4pn2/8/3P4/P4N2/1P3PPP/2R3K1 w - - 0 25",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "8/8/4k3/3p4/3P4/4K3/8/8 w - - 0 1",
+    "8/5pk1/6p1/8/3R4/6P1/5PK1/2r5 b - - 0 40",
+    "6k1/5ppp/8/8/8/8/5PPP/3Q2K1 w - - 0 1",
+};
+
+struct Options {
+    int minTimeMs = 200;
+    int repeats = 5;
+    bool json = false;
+    std::string baseline;
+    std::string filter;
+    std::string nnue;
+};
+
+struct Result {
+    std::string name;
+    double nsPerOp = 0;
+    double allocsPerOp = 0;
+    std::uint64_t ops = 0;
+};
+
+// The positions, with their move lists generated once up front so that the
+// passes time only the call they are named after
+struct Corpus {
+    std::vector<Board> boards;
+    std::vector<MoveList> pseudoLegal;   // pseudoLegal[i] belongs to boards[i]
+    std::vector<MoveList> legal;
+    AI* ai = nullptr;
+};
+
+// One pass over the corpus; returns the number of operations it performed.
+using Pass = std::uint64_t (*)(Corpus&);
+
+struct Benchmark {
+    const char* name;
+    Pass pass;
+    bool needsNetwork;
+};
+
+// Keeps the compiler from discarding the work being timed
+volatile std::uint64_t sink;
+
+void printUsage() {
+    std::cout << "Usage: bench_micro [options]\n"
+              << "  --min-time MS   run each repeat for at least MS (default 200)\n"
+              << "  --repeats N     repeats per benchmark; the fastest is reported (default 5)\n"
+              << "  --filter TEXT   only run benchmarks whose name contains TEXT\n"
+              << "  --json          print one JSON object per benchmark\n"
+              << "  --baseline FILE compare with the --json output of an earlier run\n"
+              << "  --nnue FILE     load a network: adds Nnue::evaluate, and the Board benchmarks\n"
+              << "                  include the accumulator updates\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--min-time" && hasValue) opt.minTimeMs = std::atoi(argv[++i]);
+        else if (arg == "--repeats" && hasValue) opt.repeats = std::atoi(argv[++i]);
+        else if (arg == "--filter" && hasValue) opt.filter = argv[++i];
+        else if (arg == "--baseline" && hasValue) opt.baseline = argv[++i];
+        else if (arg == "--nnue" && hasValue) opt.nnue = argv[++i];
+        else if (arg == "--json") opt.json = true;
+        else return false;
+    }
+    return opt.minTimeMs > 0 && opt.repeats > 0;
+}
+
+Result measure(const Benchmark& bench, Corpus& corpus, const Options& opt) {
+    Result best;
+    best.name = bench.name;
+    best.nsPerOp = -1;
+    bench.pass(corpus);   // warm up caches and let vectors reach their final capacity
+
+    for (int r = 0; r < opt.repeats; r++) {
+        std::uint64_t ops = 0;
+        std::uint64_t allocsBefore = allocationCount.load(std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+        std::chrono::nanoseconds elapsed{0};
+        do {
+            ops += bench.pass(corpus);
+            elapsed = std::chrono::steady_clock::now() - start;
+        } while (elapsed < std::chrono::milliseconds(opt.minTimeMs));
+        std::uint64_t allocs = allocationCount.load(std::memory_order_relaxed) - allocsBefore;
+
+        double nsPerOp = static_cast<double>(elapsed.count()) / ops;
+        if (best.nsPerOp < 0 || nsPerOp < best.nsPerOp) {
+            best.nsPerOp = nsPerOp;
+            best.allocsPerOp = static_cast<double>(allocs) / ops;
+            best.ops = ops;
+        }
+    }
+    return best;
+}
+
+const Benchmark benchmarks[] = {
+    // Every pseudo-legal move of the side to move, so roughly half the
+    // candidates are rejected when in check or pinned
+    {"Board::isLegalMove", [](Corpus& c) -> std::uint64_t {
+        std::uint64_t ops = 0, legal = 0;
+        for (std::size_t i = 0; i < c.boards.size(); i++) {
+            for (const Move& m : c.pseudoLegal[i]) legal += c.boards[i].isLegalMove(m.startX, m.startY, m.endX, m.endY);
+            ops += c.pseudoLegal[i].size();
+        }
+        sink = legal;
+        return ops;
+    }, false},
+
+    // A move has to be taken back before the next one is played, so this times
+    // the pair; the name says so to keep it apart from movePiece alone
+    {"Board::movePiece+unmakeMove", [](Corpus& c) -> std::uint64_t {
+        std::uint64_t played = 0;
+        for (std::size_t i = 0; i < c.boards.size(); i++) {
+            Board& b = c.boards[i];
+            for (const Move& m : c.legal[i]) {
+                if (b.movePiece(m.startX, m.startY, m.endX, m.endY, m.promotion)) {
+                    played++;
+                    b.unmakeMove();
+                }
+            }
+        }
+        sink = played;
+        return played;
+    }, false},
+
+    {"Board::isSquareAttacked", [](Corpus& c) -> std::uint64_t {
+        std::uint64_t attacked = 0;
+        for (Board& b : c.boards) {
+            for (int y = 0; y < 8; y++) {
+                for (int x = 0; x < 8; x++) {
+                    attacked += b.isSquareAttacked(x, y, PieceColor::White);
+                    attacked += b.isSquareAttacked(x, y, PieceColor::Black);
+                }
+            }
+        }
+        sink = attacked;
+        return c.boards.size() * 128;
+    }, false},
+
+    {"Board::isInCheck", [](Corpus& c) -> std::uint64_t {
+        std::uint64_t checks = 0;
+        for (Board& b : c.boards) {
+            checks += b.isInCheck(PieceColor::White);
+            checks += b.isInCheck(PieceColor::Black);
+        }
+        sink = checks;
+        return c.boards.size() * 2;
+    }, false},
+
+    // For the side to move, as the GUI asks after every move
+    {"Board::hasLegalMoves", [](Corpus& c) -> std::uint64_t {
+        std::uint64_t any = 0;
+        for (Board& b : c.boards) any += b.hasLegalMoves(b.getTurn());
+        sink = any;
+        return c.boards.size();
+    }, false},
+
+    {"Board::generateMoves", [](Corpus& c) -> std::uint64_t {
+        std::uint64_t count = 0;
+        for (Board& b : c.boards) {
+            MoveList moves;
+            b.generateMoves(moves);
+            count += moves.size();
+        }
+        sink = count;
+        return c.boards.size();
+    }, false},
+
+    {"AI::evaluate", [](Corpus& c) -> std::uint64_t {
+        std::uint64_t sum = 0;
+        for (Board& b : c.boards) sum += c.ai->evaluate(b);
+        sink = sum;
+        return c.boards.size();
+    }, false},
+
+    {"Nnue::evaluate", [](Corpus& c) -> std::uint64_t {
+        std::uint64_t sum = 0;
+        for (Board& b : c.boards) sum += Nnue::evaluate(b);
+        sink = sum;
+        return c.boards.size();
+    }, true},
+};
+
+// Reads the name and ns/op of each line written by --json.
+std::map<std::string, double> loadBaseline(const std::string& path) {
+    std::map<std::string, double> baseline;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::size_t name = line.find("\"bench\":\"");
+        std::size_t ns = line.find("\"ns_per_op\":");
+        if (name == std::string::npos || ns == std::string::npos) continue;
+        name += 9;
+        baseline[line.substr(name, line.find('"', name) - name)] = std::atof(line.c_str() + ns + 12);
+    }
+    return baseline;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) {
+        printUsage();
+        return 2;
+    }
+
+    Corpus positions;
+    for (const char* fen : corpus) {
+        Board b;
+        b.fromFEN(fen);
+        positions.boards.push_back(b);
+    }
+    if (!opt.nnue.empty()) {
+        if (!Nnue::load(opt.nnue)) {
+            std::cerr << "Cannot load network " << opt.nnue << "\n";
+            return 1;
+        }
+        std::cerr << "NNUE kernel: " << Nnue::kernelName(Nnue::kernel()) << "\n";
+        // From here on every move updates the accumulators
+        for (Board& b : positions.boards) b.nnueAccumulator();
+    }
+    for (const Board& b : positions.boards) {
+        positions.pseudoLegal.emplace_back();
+        b.generatePseudoLegalMoves(positions.pseudoLegal.back());
+        positions.legal.emplace_back();
+        b.generateMoves(positions.legal.back());
+    }
+    std::map<std::string, double> baseline;
+    if (!opt.baseline.empty()) {
+        baseline = loadBaseline(opt.baseline);
+        if (baseline.empty()) std::cerr << "No results in " << opt.baseline << "\n";
+    }
+
+    AI ai(PieceColor::White);
+    positions.ai = &ai;
+    if (!opt.json) {
+        std::cout << std::left << std::setw(30) << "benchmark" << std::right << std::setw(12) << "ns/op"
+                  << std::setw(12) << "allocs/op" << std::setw(14) << "ops"
+                  << (baseline.empty() ? "" : "      change") << "\n";
+    }
+
+    for (const Benchmark& bench : benchmarks) {
+        if (bench.needsNetwork && !Nnue::isLoaded()) continue;
+        if (!opt.filter.empty() && std::string(bench.name).find(opt.filter) == std::string::npos) continue;
+        Result r = measure(bench, positions, opt);
+
+        std::ostringstream change;
+        auto old = baseline.find(r.name);
+        if (old != baseline.end() && old->second > 0) {
+            change << std::showpos << std::fixed << std::setprecision(1) << 100.0 * (r.nsPerOp / old->second - 1) << "%";
+        }
+
+        if (opt.json) {
+            std::cout << "{\"bench\":\"" << r.name << "\",\"ns_per_op\":" << std::fixed << std::setprecision(2) << r.nsPerOp
+                      << ",\"allocs_per_op\":" << std::setprecision(3) << r.allocsPerOp << ",\"ops\":" << r.ops;
+            if (!change.str().empty()) std::cout << ",\"change\":\"" << change.str() << "\"";
+            std::cout << "}\n";
+        } else {
+            std::cout << std::left << std::setw(30) << r.name << std::right << std::fixed
+                      << std::setw(12) << std::setprecision(2) << r.nsPerOp
+                      << std::setw(12) << std::setprecision(3) << r.allocsPerOp
+                      << std::setw(14) << r.ops;
+            if (!change.str().empty()) std::cout << std::setw(12) << change.str();
+            std::cout << "\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,219 @@
+#include "AI.hpp"
+#include "Epd.hpp"
+#include "Notation.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct EpdPosition {
+    std::string fen;
+    std::string id;
+    std::vector<std::string> bestMoves;    // bm operands as written
+    std::vector<std::string> avoidMoves;   // am operands as written
+    std::vector<Move> bm;
+    std::vector<Move> am;
+};
+
+struct PositionResult {
+    bool valid = false;
+    bool solved = false;
+    std::string played;
+    int solvedMs = -1;   // time from which the answer was right and stayed right
+    std::uint64_t nodes = 0;
+    int timeMs = 0;
+    int depth = 0;
+    std::string json;   // the search as JSON, for --stats
+};
+
+struct Options {
+    std::string file;
+    int moveTime = 1000;
+    std::uint64_t nodes = 0;
+    int threads = 1;
+    int hashMB = 16;
+    std::string statsFile;
+};
+
+void printUsage() {
+    std::cout << "Usage: epd_runner <file.epd> [options]\n"
+              << "  --movetime MS   time per position (default 1000)\n"
+              << "  --nodes N       node budget per position instead of a time\n"
+              << "  --threads N     positions searched in parallel, one search thread each (default 1)\n"
+              << "  --hash MB       transposition table size per worker (default 16)\n"
+              << "  --stats FILE    write each position's search and statistics to FILE as JSON lines\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--movetime" && hasValue) opt.moveTime = std::atoi(argv[++i]);
+        else if (arg == "--nodes" && hasValue) opt.nodes = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--threads" && hasValue) opt.threads = std::atoi(argv[++i]);
+        else if (arg == "--hash" && hasValue) opt.hashMB = std::atoi(argv[++i]);
+        else if (arg == "--stats" && hasValue) opt.statsFile = argv[++i];
+        else if (arg[0] != '-' && opt.file.empty()) opt.file = arg;
+        else return false;
+    }
+    return !opt.file.empty() && opt.threads > 0 && opt.hashMB > 0 && (opt.moveTime > 0 || opt.nodes > 0);
+}
+
+// An EPD record is the first four FEN fields followed by "opcode operands;" operations.
+bool parseEpd(const std::string& line, EpdPosition& pos) {
+    EpdRecord record;
+    if (!parseEpdLine(line, record)) return false;
+    pos.fen = record.fen;
+    pos.id = record.id();
+    if (const std::vector<std::string>* bm = record.operands("bm")) pos.bestMoves = *bm;
+    if (const std::vector<std::string>* am = record.operands("am")) pos.avoidMoves = *am;
+
+    Board board;
+    if (!board.fromFEN(pos.fen)) return false;
+    for (const std::string& text : pos.bestMoves) {
+        Move m;
+        if (!parseSanMove(board, text, m) && !parseUciMove(board, text, m)) return false;
+        pos.bm.push_back(m);
+    }
+    for (const std::string& text : pos.avoidMoves) {
+        Move m;
+        if (!parseSanMove(board, text, m) && !parseUciMove(board, text, m)) return false;
+        pos.am.push_back(m);
+    }
+    return !pos.bm.empty() || !pos.am.empty();
+}
+
+bool isSolution(const EpdPosition& pos, const Move& m) {
+    if (!pos.bm.empty() && std::find(pos.bm.begin(), pos.bm.end(), m) == pos.bm.end()) return false;
+    return std::find(pos.am.begin(), pos.am.end(), m) == pos.am.end();
+}
+
+PositionResult solve(AI& ai, const EpdPosition& pos, const Options& opt) {
+    Board board;
+    board.fromFEN(pos.fen);
+
+    PositionResult r;
+    ai.clearHash();
+    ai.setInfoCallback([&](const SearchResult& info) {
+        if (!isSolution(pos, info.bestMove)) r.solvedMs = -1;
+        else if (r.solvedMs < 0) r.solvedMs = info.timeMs;
+    });
+
+    SearchLimits limits;
+    if (opt.nodes > 0) limits.nodes = opt.nodes;
+    else limits.moveTime = opt.moveTime;
+    SearchResult result = ai.search(board, limits);
+
+    r.valid = true;
+    r.solved = isSolution(pos, result.bestMove);
+    if (!r.solved) r.solvedMs = -1;
+    else if (r.solvedMs < 0) r.solvedMs = result.timeMs;
+    r.played = result.bestMove.startX >= 0 ? moveToSan(board, result.bestMove) : "none";
+    r.nodes = result.nodes;
+    r.timeMs = result.timeMs;
+    r.depth = result.depth;
+    if (!opt.statsFile.empty()) r.json = toJson(result);
+    return r;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) {
+        printUsage();
+        return 2;
+    }
+
+    std::ifstream file(opt.file);
+    if (!file) {
+        std::cerr << "Cannot open " << opt.file << "\n";
+        return 1;
+    }
+
+    std::vector<EpdPosition> positions;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        if (isEpdComment(line)) continue;
+        EpdPosition pos;
+        if (!parseEpd(line, pos)) {
+            std::cerr << opt.file << ":" << lineNumber << ": skipped, no legal bm/am move or bad FEN\n";
+            continue;
+        }
+        if (pos.id.empty()) pos.id = "line " + std::to_string(lineNumber);
+        positions.push_back(pos);
+    }
+    if (positions.empty()) {
+        std::cerr << "No positions to solve\n";
+        return 1;
+    }
+
+    // Workers take the next unsolved position; each has its own engine and table
+    std::vector<PositionResult> results(positions.size());
+    std::atomic<std::size_t> next{0};
+    auto worker = [&]() {
+        AI ai(PieceColor::White);
+        ai.setHashSize(opt.hashMB);
+        for (std::size_t i = next++; i < positions.size(); i = next++) {
+            results[i] = solve(ai, positions[i], opt);
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    int workerCount = std::min<int>(opt.threads, static_cast<int>(positions.size()));
+    for (int i = 0; i < workerCount; i++) workers.emplace_back(worker);
+    for (std::thread& w : workers) w.join();
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!opt.statsFile.empty()) {
+        std::ofstream stats(opt.statsFile);
+        for (std::size_t i = 0; i < positions.size(); i++) {
+            if (!results[i].valid) continue;
+            stats << "{\"id\":" << jsonString(positions[i].id) << ",\"solved\":" << (results[i].solved ? "true" : "false")
+                  << ",\"search\":" << results[i].json << "}\n";
+        }
+        if (!stats) std::cerr << "Cannot write " << opt.statsFile << "\n";
+    }
+
+    int solved = 0;
+    std::uint64_t nodes = 0;
+    long long solveTimeSum = 0;
+    for (std::size_t i = 0; i < positions.size(); i++) {
+        const EpdPosition& pos = positions[i];
+        const PositionResult& r = results[i];
+        nodes += r.nodes;
+        if (r.solved) {
+            solved++;
+            solveTimeSum += r.solvedMs;
+        }
+
+        std::string expected;
+        for (const std::string& m : pos.bestMoves) expected += " bm " + m;
+        for (const std::string& m : pos.avoidMoves) expected += " am " + m;
+        std::cout << (r.solved ? "ok   " : "FAIL ") << std::left << std::setw(24) << pos.id
+                  << std::setw(8) << r.played << std::setw(20) << expected
+                  << "depth " << std::setw(4) << r.depth;
+        if (r.solved) std::cout << "solved at " << r.solvedMs << " ms";
+        std::cout << "\n";
+    }
+
+    std::cout << "\nSolved: " << solved << "/" << positions.size() << " (" << std::fixed << std::setprecision(1)
+              << 100.0 * solved / positions.size() << "%)\n";
+    if (solved) std::cout << "Average time to solution: " << solveTimeSum / solved << " ms\n";
+    std::cout << "Nodes: " << nodes << "\n"
+              << "Time: " << static_cast<long long>(wallSeconds * 1000) << " ms\n"
+              << "NPS: " << static_cast<std::uint64_t>(wallSeconds > 0 ? nodes / wallSeconds : 0) << "\n";
+    return 0;
+}
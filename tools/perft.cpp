@@ -0,0 +1,222 @@
+#include "Board.hpp"
+#include "Notation.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+struct ReferencePosition {
+    const char* name;
+    const char* fen;
+    int quickDepth;
+    std::vector<std::uint64_t> counts;   // counts[d - 1] is perft(d)
+};
+
+// Standard perft results from the Chess Programming Wiki.
+const std::vector<ReferencePosition> referencePositions = {
+    {"startpos", START_FEN, 5,
+     {20, 400, 8902, 197281, 4865609, 119060324}},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4,
+     {48, 2039, 97862, 4085603, 193690690}},
+    {"position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5,
+     {14, 191, 2812, 43238, 674624, 11030083}},
+    {"position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4,
+     {6, 264, 9467, 422333, 15833292}},
+    {"position4-mirrored", "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1", 4,
+     {6, 264, 9467, 422333, 15833292}},
+    {"position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4,
+     {44, 1486, 62379, 2103487, 89941194}},
+    {"position6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4,
+     {46, 2079, 89890, 3894594, 164075551}},
+};
+
+// Subtree counts keyed by position and depth, shared by all threads with the
+// same key-XOR-data check the search transposition table uses.
+class PerftHash {
+public:
+    explicit PerftHash(std::size_t megabytes) {
+        std::size_t count = 1;
+        const std::size_t wanted = megabytes * 1024 * 1024 / sizeof(Entry);
+        while (count * 2 <= wanted) count *= 2;
+        entries = std::vector<Entry>(count);
+    }
+
+    bool probe(std::uint64_t key, int depth, std::uint64_t& nodes) const {
+        const Entry& e = entries[(key ^ depth) & (entries.size() - 1)];
+        std::uint64_t data = e.data.load(std::memory_order_relaxed);
+        if ((e.keyXorData.load(std::memory_order_relaxed) ^ data) != key || (data & 0xFF) != static_cast<std::uint64_t>(depth)) return false;
+        nodes = data >> 8;
+        return true;
+    }
+
+    void store(std::uint64_t key, int depth, std::uint64_t nodes) {
+        Entry& e = entries[(key ^ depth) & (entries.size() - 1)];
+        std::uint64_t data = (nodes << 8) | static_cast<std::uint64_t>(depth);
+        e.data.store(data, std::memory_order_relaxed);
+        e.keyXorData.store(key ^ data, std::memory_order_relaxed);
+    }
+
+private:
+    struct Entry {
+        std::atomic<std::uint64_t> keyXorData{0};
+        std::atomic<std::uint64_t> data{0};
+    };
+    std::vector<Entry> entries;
+};
+
+struct Options {
+    std::string fen = START_FEN;
+    int depth = 0;
+    bool divide = false;
+    bool suite = false;
+    int hashMB = 0;
+    int threads = 1;
+};
+
+std::uint64_t perft(Board& board, int depth, PerftHash* hash) {
+    if (depth == 0) return 1;
+    MoveList moves;
+    board.generateMoves(moves);
+    if (depth == 1) return moves.size();
+
+    std::uint64_t nodes = 0;
+    if (hash && hash->probe(board.getHash(), depth, nodes)) return nodes;
+    for (const Move& m : moves) {
+        board.makeMove(m);
+        nodes += perft(board, depth - 1, hash);
+        board.unmakeMove();
+    }
+    if (hash) hash->store(board.getHash(), depth, nodes);
+    return nodes;
+}
+
+// Splits the root moves across threads; each thread searches its own copy of the
+// board. hash is null when hashing is off.
+std::uint64_t rootPerft(const Board& root, int depth, int threads, PerftHash* hash, bool divide) {
+    if (depth == 0) return 1;
+    MoveList moves;
+    root.generateMoves(moves);
+
+    std::vector<std::uint64_t> counts(moves.size(), 0);
+    std::atomic<int> next{0};
+    auto worker = [&]() {
+        Board board = root;
+        for (int i = next++; i < moves.size(); i = next++) {
+            board.makeMove(moves[i]);
+            counts[i] = perft(board, depth - 1, hash);
+            board.unmakeMove();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+
+    std::uint64_t total = 0;
+    for (int i = 0; i < moves.size(); i++) {
+        if (divide) std::cout << moveToUci(moves[i]) << ": " << counts[i] << "\n";
+        total += counts[i];
+    }
+    return total;
+}
+
+void printUsage() {
+    std::cout << "Usage: perft [options]\n"
+              << "  --fen \"<fen>\"   position to count (default: start position)\n"
+              << "  --depth N       depth to count to (default 5, or each suite position's quick depth)\n"
+              << "  --divide        print the node count below each root move\n"
+              << "  --suite         check the standard reference positions\n"
+              << "  --hash MB       cache subtree counts in a shared hash table\n"
+              << "  --threads N     split the root moves across N threads\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--fen" && hasValue) opt.fen = argv[++i];
+        else if (arg == "--depth" && hasValue) opt.depth = std::atoi(argv[++i]);
+        else if (arg == "--hash" && hasValue) opt.hashMB = std::atoi(argv[++i]);
+        else if (arg == "--threads" && hasValue) opt.threads = std::atoi(argv[++i]);
+        else if (arg == "--divide") opt.divide = true;
+        else if (arg == "--suite") opt.suite = true;
+        else return false;
+    }
+    if (opt.threads < 1) opt.threads = 1;
+    return opt.depth >= 0;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int runSuite(const Options& opt, PerftHash* hash) {
+    int failures = 0;
+    std::uint64_t totalNodes = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (const ReferencePosition& ref : referencePositions) {
+        Board board;
+        board.fromFEN(ref.fen);
+        int maxDepth = opt.depth > 0 ? opt.depth : ref.quickDepth;
+        if (maxDepth > static_cast<int>(ref.counts.size())) maxDepth = static_cast<int>(ref.counts.size());
+
+        for (int d = 1; d <= maxDepth; d++) {
+            std::uint64_t nodes = rootPerft(board, d, opt.threads, hash, false);
+            bool ok = nodes == ref.counts[d - 1];
+            totalNodes += nodes;
+            if (!ok) failures++;
+            std::cout << ref.name << " depth " << d << ": " << nodes;
+            if (!ok) std::cout << " FAIL (expected " << ref.counts[d - 1] << ")";
+            std::cout << "\n";
+        }
+    }
+
+    double seconds = secondsSince(start);
+    std::cout << "\nNodes: " << totalNodes << "\n"
+              << "Time: " << static_cast<long long>(seconds * 1000) << " ms\n"
+              << "NPS: " << static_cast<long long>(seconds > 0 ? totalNodes / seconds : 0) << "\n"
+              << (failures ? "FAILED: " + std::to_string(failures) + " mismatches" : std::string("All counts match")) << "\n";
+    return failures ? 1 : 0;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) {
+        printUsage();
+        return 2;
+    }
+    // One table for the whole run, so the suite reuses counts from earlier depths
+    std::unique_ptr<PerftHash> hash;
+    if (opt.hashMB > 0) hash = std::make_unique<PerftHash>(opt.hashMB);
+    if (opt.suite) return runSuite(opt, hash.get());
+
+    Board board;
+    if (!board.fromFEN(opt.fen)) {
+        std::cerr << "Invalid FEN: " << opt.fen << "\n";
+        return 2;
+    }
+    int depth = opt.depth > 0 ? opt.depth : 5;
+
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t nodes = rootPerft(board, depth, opt.threads, hash.get(), opt.divide);
+    double seconds = secondsSince(start);
+
+    std::cout << (opt.divide ? "\n" : "")
+              << "Nodes: " << nodes << "\n"
+              << "Time: " << static_cast<long long>(seconds * 1000) << " ms\n"
+              << "NPS: " << static_cast<long long>(seconds > 0 ? nodes / seconds : 0) << "\n";
+    return 0;
+}
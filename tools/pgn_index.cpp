@@ -0,0 +1,297 @@
+#include "Board.hpp"
+#include "MappedFile.hpp"
+#include "Notation.hpp"
+#include "Pgn.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// Index file layout: the header, then the entries sorted by key and move. The
+// key is Board::getHash of the position before the move.
+struct IndexHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t entries;
+};
+constexpr char INDEX_MAGIC[4] = {'A', 'J', 'P', 'I'};
+constexpr std::uint32_t INDEX_VERSION = 2;
+
+// One move played from one position, with the results of the games it was played in
+struct IndexEntry {
+    std::uint64_t key;
+    std::uint16_t move;   // from + 64 * to + 4096 * promotion, squares a1 = 0
+    std::uint16_t reserved;
+    std::uint32_t whiteWins;
+    std::uint32_t draws;
+    std::uint32_t blackWins;
+
+    std::uint32_t games() const { return whiteWins + draws + blackWins; }
+    bool operator<(const IndexEntry& other) const {
+        return key != other.key ? key < other.key : move < other.move;
+    }
+};
+static_assert(sizeof(IndexEntry) == 24, "IndexEntry is written to disk as is");
+
+// Entries a worker collects before it first merges duplicates (24 MB)
+const std::size_t INITIAL_ENTRIES = 1 << 20;
+
+struct Options {
+    std::vector<std::string> inputs;
+    std::string output = "games.idx";
+    int threads = 0;
+    int plies = 40;
+    unsigned minGames = 1;
+    std::string query;
+    std::string fen = START_FEN;
+};
+
+struct Chunk {
+    std::size_t file;
+    std::size_t begin, end;
+};
+
+struct Counters {
+    std::uint64_t games = 0;
+    std::uint64_t unfinished = 0;   // no result, not indexed
+    std::uint64_t errors = 0;       // stopped at an illegal or unreadable move
+    std::uint64_t plies = 0;
+};
+
+void printUsage() {
+    std::cout << "Usage: pgn_index <file.pgn>... [options]\n"
+              << "       pgn_index --query FILE [--fen \"<fen>\"]\n"
+              << "  --output FILE     index to write (default games.idx)\n"
+              << "  --threads N       files are read in chunks on N threads (default: all cores)\n"
+              << "  --plies N         index the first N plies of every game (default 40)\n"
+              << "  --min-games N     leave out moves played in fewer than N games (default 1)\n"
+              << "  --query FILE      print the moves an index holds for a position\n"
+              << "  --fen \"<fen>\"     position to query (default: start position)\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--output" && hasValue) opt.output = argv[++i];
+        else if (arg == "--threads" && hasValue) opt.threads = std::atoi(argv[++i]);
+        else if (arg == "--plies" && hasValue) opt.plies = std::atoi(argv[++i]);
+        else if (arg == "--min-games" && hasValue) opt.minGames = static_cast<unsigned>(std::atoi(argv[++i]));
+        else if (arg == "--query" && hasValue) opt.query = argv[++i];
+        else if (arg == "--fen" && hasValue) opt.fen = argv[++i];
+        else if (arg[0] != '-') opt.inputs.push_back(arg);
+        else return false;
+    }
+    if (opt.threads <= 0) opt.threads = std::max(1u, std::thread::hardware_concurrency());
+    return (!opt.inputs.empty() || !opt.query.empty()) && opt.plies > 0;
+}
+
+std::uint16_t encodeMove(const Move& m) {
+    return static_cast<std::uint16_t>(makeSquare(m.startX, m.startY) + 64 * makeSquare(m.endX, m.endY) +
+                                      4096 * static_cast<int>(m.promotion));
+}
+
+Move decodeMove(std::uint16_t code) {
+    const int from = code & 63, to = (code >> 6) & 63;
+    return {squareX(from), squareY(from), squareX(to), squareY(to), 0, static_cast<PieceType>(code >> 12)};
+}
+
+// Sorts the entries and adds up those for the same position and move
+void compact(std::vector<IndexEntry>& entries) {
+    std::sort(entries.begin(), entries.end());
+    std::size_t out = 0;
+    for (std::size_t i = 0; i < entries.size(); i++) {
+        if (out > 0 && entries[out - 1].key == entries[i].key && entries[out - 1].move == entries[i].move) {
+            entries[out - 1].whiteWins += entries[i].whiteWins;
+            entries[out - 1].draws += entries[i].draws;
+            entries[out - 1].blackWins += entries[i].blackWins;
+        } else {
+            entries[out++] = entries[i];
+        }
+    }
+    entries.resize(out);
+}
+
+// Replays the games of one chunk, adding an entry for every indexed ply
+void indexChunk(std::string_view text, int maxPlies, std::vector<IndexEntry>& entries, Counters& counters) {
+    PgnReader reader(text);
+    PgnGame game;
+    Board board;
+    while (reader.next(game)) {
+        // Merging duplicates when the vector is full lets it grow only once most
+        // of its entries are distinct
+        if (entries.capacity() - entries.size() < static_cast<std::size_t>(maxPlies)) {
+            compact(entries);
+            if (entries.size() > entries.capacity() / 2) entries.reserve(entries.capacity() * 2);
+        }
+        counters.games++;
+        const std::string_view result = game.tag("Result");
+        IndexEntry entry = {};
+        if (result == "1-0") entry.whiteWins = 1;
+        else if (result == "1/2-1/2") entry.draws = 1;
+        else if (result == "0-1") entry.blackWins = 1;
+        else {
+            counters.unfinished++;
+            continue;
+        }
+
+        const std::string_view fen = game.tag("FEN");
+        if (fen.empty()) board.reset();
+        else if (!board.fromFEN(std::string(fen))) {
+            counters.errors++;
+            continue;
+        }
+
+        PgnMoveTokens tokens(game.movetext);
+        std::string_view san;
+        for (int ply = 0; ply < maxPlies && tokens.next(san); ply++) {
+            Move m;
+            if (!parseSanMove(board, san, m)) {
+                counters.errors++;
+                break;
+            }
+            entry.key = board.getHash();
+            entry.move = encodeMove(m);
+            entries.push_back(entry);
+            board.makeMove(m);
+            counters.plies++;
+        }
+    }
+}
+
+int query(const Options& opt) {
+    MappedFile file;
+    IndexHeader header;
+    if (!file.open(opt.query) || file.size() < sizeof(header)) {
+        std::cerr << "Cannot open " << opt.query << "\n";
+        return 1;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, INDEX_MAGIC, 4) != 0 || header.version != INDEX_VERSION ||
+        file.size() != sizeof(header) + header.entries * sizeof(IndexEntry)) {
+        std::cerr << opt.query << " is not a pgn_index file\n";
+        return 1;
+    }
+    Board board;
+    if (!board.fromFEN(opt.fen)) {
+        std::cerr << "Invalid FEN\n";
+        return 1;
+    }
+
+    const IndexEntry* begin = reinterpret_cast<const IndexEntry*>(file.data() + sizeof(header));
+    const IndexEntry* end = begin + header.entries;
+    const std::uint64_t key = board.getHash();
+    const IndexEntry* first = std::lower_bound(begin, end, IndexEntry{key, 0, 0, 0, 0, 0});
+    std::vector<IndexEntry> moves;
+    for (const IndexEntry* e = first; e != end && e->key == key; e++) moves.push_back(*e);
+    std::sort(moves.begin(), moves.end(), [](const IndexEntry& a, const IndexEntry& b) { return a.games() > b.games(); });
+
+    if (moves.empty()) std::cout << "Position not in the index\n";
+    for (const IndexEntry& e : moves) {
+        const double games = e.games();
+        std::cout << std::left << std::setw(8) << moveToSan(board, decodeMove(e.move)) << std::right
+                  << std::setw(10) << e.games() << std::fixed << std::setprecision(1)
+                  << std::setw(8) << 100 * e.whiteWins / games << "%"
+                  << std::setw(8) << 100 * e.draws / games << "%"
+                  << std::setw(8) << 100 * e.blackWins / games << "%\n";
+    }
+    return 0;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) {
+        printUsage();
+        return 2;
+    }
+    if (!opt.query.empty()) return query(opt);
+
+    std::vector<std::unique_ptr<MappedFile>> files;
+    std::vector<Chunk> chunks;
+    for (const std::string& path : opt.inputs) {
+        auto file = std::make_unique<MappedFile>();
+        if (!file->open(path)) {
+            std::cerr << "Cannot open " << path << "\n";
+            return 1;
+        }
+        // Several chunks per thread, cut at game boundaries, so that threads that
+        // finish early pick up more work
+        const std::string_view text(reinterpret_cast<const char*>(file->data()), file->size());
+        const std::size_t chunkCount = static_cast<std::size_t>(opt.threads) * 8;
+        std::size_t begin = 0;
+        for (std::size_t i = 1; i <= chunkCount && begin < text.size(); i++) {
+            std::size_t end = i == chunkCount ? text.size() : findGameStart(text, std::max(begin + 1, text.size() / chunkCount * i));
+            if (end > begin) chunks.push_back({files.size(), begin, end});
+            begin = end;
+        }
+        files.push_back(std::move(file));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::vector<IndexEntry>> entries(opt.threads);
+    std::vector<Counters> counters(opt.threads);
+    std::atomic<std::size_t> nextChunk{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < opt.threads; t++) {
+        workers.emplace_back([&, t]() {
+            entries[t].reserve(INITIAL_ENTRIES);
+            for (std::size_t i = nextChunk++; i < chunks.size(); i = nextChunk++) {
+                const Chunk& c = chunks[i];
+                const char* data = reinterpret_cast<const char*>(files[c.file]->data());
+                indexChunk(std::string_view(data + c.begin, c.end - c.begin), opt.plies, entries[t], counters[t]);
+            }
+            compact(entries[t]);
+        });
+    }
+    for (std::thread& w : workers) w.join();
+
+    Counters total;
+    std::vector<IndexEntry> merged;
+    for (int t = 0; t < opt.threads; t++) {
+        total.games += counters[t].games;
+        total.unfinished += counters[t].unfinished;
+        total.errors += counters[t].errors;
+        total.plies += counters[t].plies;
+        merged.insert(merged.end(), entries[t].begin(), entries[t].end());
+        std::vector<IndexEntry>().swap(entries[t]);
+    }
+    compact(merged);
+    merged.erase(std::remove_if(merged.begin(), merged.end(), [&](const IndexEntry& e) { return e.games() < opt.minGames; }),
+                 merged.end());
+
+    std::ofstream out(opt.output, std::ios::binary);
+    IndexHeader header;
+    std::memcpy(header.magic, INDEX_MAGIC, 4);
+    header.version = INDEX_VERSION;
+    header.entries = merged.size();
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(merged.data()), static_cast<std::streamsize>(merged.size() * sizeof(IndexEntry)));
+    if (!out) {
+        std::cerr << "Cannot write " << opt.output << "\n";
+        return 1;
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Games: " << total.games << " (" << total.unfinished << " without a result, "
+              << total.errors << " stopped at an unreadable move)\n"
+              << "Plies indexed: " << total.plies << "\n"
+              << "Entries: " << merged.size() << " in " << opt.output << "\n"
+              << "Time: " << static_cast<long long>(seconds * 1000) << " ms\n"
+              << "Games per minute: " << static_cast<std::uint64_t>(seconds > 0 ? total.games * 60 / seconds : 0) << "\n";
+    return 0;
+}
@@ -0,0 +1,443 @@
+#include "AI.hpp"
+#include "Bitbases.hpp"
+#include "Epd.hpp"
+#include "Notation.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// Games still running after this many plies are drawn; it also bounds the
+// memory a game needs.
+const int MAX_GAME_PLIES = 600;
+
+struct EngineConfig {
+    std::string name;
+    SearchLimits limits;
+    int tcBaseMs = 0;   // game clock; 0 means the limits above apply to every move
+    int tcIncMs = 0;
+    int hashMB = 16;
+    std::string book;
+};
+
+struct Options {
+    int games = 100;
+    int concurrency = 1;
+    std::string openings;
+    int randomPlies = 8;
+    std::string pgn;
+    unsigned seed = 1;
+    bool sprt = false;
+    double elo0 = 0;
+    double elo1 = 5;
+    double alpha = 0.05;
+    double beta = 0.05;
+    EngineConfig engines[2];
+};
+
+struct GameResult {
+    int whiteScore = 1;   // 2 win, 1 draw, 0 loss, from White's side
+    std::string reason;
+    bool adjudicated = false;
+};
+
+void printUsage() {
+    std::cout << "Usage: selfplay [options]\n"
+              << "  --games N          games to play, in pairs with colours reversed (default 100)\n"
+              << "  --concurrency N    games played at once, one search thread each (default 1)\n"
+              << "  --openings FILE    FEN or EPD start positions, one per line, used in turn\n"
+              << "  --random-plies N   without an opening file, start after N random plies (default 8)\n"
+              << "  --pgn FILE         append every finished game to FILE\n"
+              << "  --seed N           seed for the random openings (default 1)\n"
+              << "  --sprt ELO0 ELO1   stop once the test accepts H0 (elo0) or H1 (elo1)\n"
+              << "  --alpha A --beta B SPRT error rates (default 0.05 each)\n"
+              << "  --engine1 \"...\"    first engine, as key=value pairs:\n"
+              << "  --engine2 \"...\"      name=, depth=, nodes=, movetime=MS, tc=SECONDS+INC, hash=MB, book=FILE\n"
+              << "  --each \"...\"       settings applied to both engines before their own\n";
+}
+
+bool parseTimeControl(const std::string& text, EngineConfig& engine) {
+    std::size_t plus = text.find('+');
+    double base = std::atof(text.substr(0, plus).c_str());
+    double inc = plus == std::string::npos ? 0 : std::atof(text.substr(plus + 1).c_str());
+    engine.tcBaseMs = static_cast<int>(base * 1000);
+    engine.tcIncMs = static_cast<int>(inc * 1000);
+    return engine.tcBaseMs > 0;
+}
+
+bool parseEngine(const std::string& text, EngineConfig& engine) {
+    std::istringstream in(text);
+    std::string pair;
+    while (in >> pair) {
+        std::size_t eq = pair.find('=');
+        if (eq == std::string::npos) return false;
+        std::string key = pair.substr(0, eq);
+        std::string value = pair.substr(eq + 1);
+        if (key == "name") engine.name = value;
+        else if (key == "depth") engine.limits.depth = std::atoi(value.c_str());
+        else if (key == "nodes") engine.limits.nodes = std::strtoull(value.c_str(), nullptr, 10);
+        else if (key == "movetime") engine.limits.moveTime = std::atoi(value.c_str());
+        else if (key == "tc") {
+            if (!parseTimeControl(value, engine)) return false;
+        }
+        else if (key == "hash") engine.hashMB = std::atoi(value.c_str());
+        else if (key == "book") engine.book = value;
+        else return false;
+    }
+    return engine.hashMB > 0;
+}
+
+bool parseOptions(int argc, char* argv[], Options& opt) {
+    std::string each, engineText[2];
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--games" && hasValue) opt.games = std::atoi(argv[++i]);
+        else if (arg == "--concurrency" && hasValue) opt.concurrency = std::atoi(argv[++i]);
+        else if (arg == "--openings" && hasValue) opt.openings = argv[++i];
+        else if (arg == "--random-plies" && hasValue) opt.randomPlies = std::atoi(argv[++i]);
+        else if (arg == "--pgn" && hasValue) opt.pgn = argv[++i];
+        else if (arg == "--seed" && hasValue) opt.seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--sprt" && i + 2 < argc) {
+            opt.sprt = true;
+            opt.elo0 = std::atof(argv[++i]);
+            opt.elo1 = std::atof(argv[++i]);
+        }
+        else if (arg == "--alpha" && hasValue) opt.alpha = std::atof(argv[++i]);
+        else if (arg == "--beta" && hasValue) opt.beta = std::atof(argv[++i]);
+        else if (arg == "--engine1" && hasValue) engineText[0] = argv[++i];
+        else if (arg == "--engine2" && hasValue) engineText[1] = argv[++i];
+        else if (arg == "--each" && hasValue) each = argv[++i];
+        else return false;
+    }
+
+    for (int e = 0; e < 2; e++) {
+        EngineConfig& engine = opt.engines[e];
+        engine.name = e == 0 ? "Ajedrez A" : "Ajedrez B";
+        if (!parseEngine(each, engine) || !parseEngine(engineText[e], engine)) return false;
+        const SearchLimits& l = engine.limits;
+        if (!engine.tcBaseMs && !l.depth && !l.nodes && !l.moveTime) engine.limits.nodes = 20000;
+    }
+    if (opt.sprt && opt.elo1 <= opt.elo0) return false;
+    return opt.games > 0 && opt.concurrency > 0 && opt.randomPlies >= 0 &&
+           opt.alpha > 0 && opt.alpha < 1 && opt.beta > 0 && opt.beta < 1;
+}
+
+bool loadOpenings(const std::string& path, std::vector<std::string>& openings) {
+    std::ifstream file(path);
+    if (!file) return false;
+    std::string line;
+    EpdRecord record;
+    while (std::getline(file, line)) {
+        // EPD operations are ignored
+        Board board;
+        if (!isEpdComment(line) && parseEpdLine(line, record) && board.fromFEN(record.fen) && board.hasLegalMoves(board.getTurn())) {
+            openings.push_back(board.toFEN());
+        }
+    }
+    return !openings.empty();
+}
+
+// Start position after a few random plies, the same for both games of a pair.
+std::string randomOpening(int plies, std::uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    for (;;) {
+        Board board;
+        board.fromFEN(START_FEN);
+        bool ok = true;
+        for (int i = 0; i < plies && ok; i++) {
+            MoveList moves;
+            board.generateMoves(moves);
+            if (moves.empty()) ok = false;
+            else board.makeMove(moves[static_cast<int>(rng() % moves.size())]);
+        }
+        if (ok && board.hasLegalMoves(board.getTurn())) return board.toFEN();
+    }
+}
+
+// Win, draw and loss counts from the first engine's side.
+struct Tally {
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+
+    int games() const { return wins + draws + losses; }
+    double score() const { return games() ? (wins + 0.5 * draws) / games() : 0.5; }
+    // Variance of a single game's score
+    double variance() const {
+        if (!games()) return 0;
+        double p = score();
+        return (wins * (1 - p) * (1 - p) + draws * (0.5 - p) * (0.5 - p) + losses * p * p) / games();
+    }
+};
+
+double scoreToElo(double score) {
+    score = std::min(std::max(score, 1e-6), 1 - 1e-6);
+    return 400.0 * std::log10(score / (1.0 - score));
+}
+
+double eloToScore(double elo) { return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0)); }
+
+// Log-likelihood ratio of elo1 against elo0 under the normal approximation of
+// the trinomial game result.
+double logLikelihoodRatio(const Tally& t, double elo0, double elo1) {
+    double var = t.variance();
+    if (t.games() == 0 || var <= 0) return 0;
+    double s0 = eloToScore(elo0), s1 = eloToScore(elo1);
+    return t.games() * (s1 - s0) * (2 * t.score() - s0 - s1) / (2 * var);
+}
+
+std::string resultText(int whiteScore) {
+    return whiteScore == 2 ? "1-0" : whiteScore == 0 ? "0-1" : "1/2-1/2";
+}
+
+std::string today() {
+    std::time_t now = std::time(nullptr);
+    char text[16];
+    std::strftime(text, sizeof(text), "%Y.%m.%d", std::localtime(&now));
+    return text;
+}
+
+class Worker {
+public:
+    explicit Worker(const Options& opt) : opt(opt) {
+        for (int e = 0; e < 2; e++) {
+            ai[e].setHashSize(opt.engines[e].hashMB);
+            if (!opt.engines[e].book.empty()) ai[e].loadBook(opt.engines[e].book);
+        }
+        hashes.reserve(MAX_GAME_PLIES + 1);
+    }
+
+    // Plays one game with engine whiteEngine as White; the moves are appended to
+    // san in order. Returns the result from White's side.
+    GameResult play(const std::string& fen, int whiteEngine, std::vector<std::string>& san) {
+        Board board;
+        board.fromFEN(fen);
+        for (AI& engine : ai) engine.clearHash();
+        hashes.clear();
+        hashes.push_back(board.getHash());
+
+        int clock[2] = {opt.engines[0].tcBaseMs, opt.engines[1].tcBaseMs};
+        GameResult result;
+        for (int ply = 0;; ply++) {
+            const PieceColor turn = board.getTurn();
+            const int e = turn == PieceColor::White ? whiteEngine : 1 - whiteEngine;
+            const int winIfMover = turn == PieceColor::White ? 2 : 0;
+
+            if (!board.hasLegalMoves(turn)) {
+                bool mate = board.isInCheck(turn);
+                return finish(result, mate ? 2 - winIfMover : 1, mate ? "checkmate" : "stalemate", false);
+            }
+            if (board.getHalfmoveClock() >= 100) return finish(result, 1, "fifty-move rule", false);
+            if (std::count(hashes.begin(), hashes.end(), board.getHash()) >= 3) {
+                return finish(result, 1, "threefold repetition", false);
+            }
+            Bitbases::Result known;
+            if (Bitbases::probe(board, known)) {
+                int score = known == Bitbases::Result::Draw ? 1 : known == Bitbases::Result::Win ? winIfMover : 2 - winIfMover;
+                return finish(result, score, "endgame bitbase", true);
+            }
+            if (ply >= MAX_GAME_PLIES) return finish(result, 1, "move limit", true);
+
+            const EngineConfig& config = opt.engines[e];
+            SearchLimits limits = config.limits;
+            if (config.tcBaseMs) {
+                const int other = 1 - e;
+                const bool white = turn == PieceColor::White;
+                limits.whiteTime = white ? clock[e] : clock[other];
+                limits.blackTime = white ? clock[other] : clock[e];
+                limits.whiteIncrement = white ? config.tcIncMs : opt.engines[other].tcIncMs;
+                limits.blackIncrement = white ? opt.engines[other].tcIncMs : config.tcIncMs;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            Move m = ai[e].search(board, limits).bestMove;
+            int elapsed = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count());
+
+            if (config.tcBaseMs) {
+                clock[e] -= elapsed;
+                if (clock[e] < 0) return finish(result, 2 - winIfMover, "time forfeit", false);
+                clock[e] += config.tcIncMs;
+            }
+
+            std::string text = m.startX >= 0 ? moveToSan(board, m) : "";
+            if (text.empty() || !board.movePiece(m.startX, m.startY, m.endX, m.endY, m.promotion)) {
+                return finish(result, 2 - winIfMover, "illegal move", false);
+            }
+            san.push_back(text);
+            if (board.getHalfmoveClock() == 0) hashes.clear();
+            hashes.push_back(board.getHash());
+        }
+    }
+
+private:
+    static GameResult finish(GameResult& r, int whiteScore, const char* reason, bool adjudicated) {
+        r.whiteScore = whiteScore;
+        r.reason = reason;
+        r.adjudicated = adjudicated;
+        return r;
+    }
+
+    const Options& opt;
+    AI ai[2] = {AI(PieceColor::White), AI(PieceColor::White)};
+    // Keys since the last irreversible move, for repetition
+    std::vector<std::uint64_t> hashes;
+};
+
+std::string formatPgn(const Options& opt, int round, const std::string& fen, int whiteEngine,
+                      const std::vector<std::string>& san, const GameResult& result, const std::string& date) {
+    std::ostringstream out;
+    const std::string outcome = resultText(result.whiteScore);
+    out << "[Event \"Ajedrez selfplay\"]\n"
+        << "[Site \"?\"]\n"
+        << "[Date \"" << date << "\"]\n"
+        << "[Round \"" << round << "\"]\n"
+        << "[White \"" << opt.engines[whiteEngine].name << "\"]\n"
+        << "[Black \"" << opt.engines[1 - whiteEngine].name << "\"]\n"
+        << "[Result \"" << outcome << "\"]\n";
+    if (fen != START_FEN) out << "[SetUp \"1\"]\n[FEN \"" << fen << "\"]\n";
+    out << "[PlyCount \"" << san.size() << "\"]\n"
+        << "[Termination \"" << (result.adjudicated ? "adjudication" : result.reason == "time forfeit" ? "time forfeit" : "normal") << "\"]\n\n";
+
+    // Move text wrapped at 80 columns, numbered from the start position's move number
+    Board board;
+    board.fromFEN(fen);
+    int moveNumber = board.getFullmoveNumber();
+    bool whiteToMove = board.getTurn() == PieceColor::White;
+    std::string line;
+    auto emit = [&](const std::string& token) {
+        if (!line.empty() && line.size() + 1 + token.size() > 80) {
+            out << line << "\n";
+            line.clear();
+        }
+        line += (line.empty() ? "" : " ") + token;
+    };
+    for (std::size_t i = 0; i < san.size(); i++) {
+        if (whiteToMove) emit(std::to_string(moveNumber) + ". " + san[i]);
+        else if (i == 0) emit(std::to_string(moveNumber) + "... " + san[i]);
+        else emit(san[i]);
+        if (!whiteToMove) moveNumber++;
+        whiteToMove = !whiteToMove;
+    }
+    emit("{" + result.reason + "}");
+    emit(outcome);
+    out << line << "\n\n";
+    return out.str();
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) {
+        printUsage();
+        return 2;
+    }
+
+    std::vector<std::string> openings;
+    if (!opt.openings.empty() && !loadOpenings(opt.openings, openings)) {
+        std::cerr << "No usable positions in " << opt.openings << "\n";
+        return 1;
+    }
+    std::ofstream pgn;
+    if (!opt.pgn.empty()) {
+        pgn.open(opt.pgn, std::ios::app);
+        if (!pgn) {
+            std::cerr << "Cannot write " << opt.pgn << "\n";
+            return 1;
+        }
+    }
+    // Games that reach a covered ending are adjudicated
+    Bitbases::init("bitbases", opt.concurrency);
+
+    const double lowerBound = std::log(opt.beta / (1 - opt.alpha));
+    const double upperBound = std::log((1 - opt.beta) / opt.alpha);
+    const std::string date = today();
+
+    std::mutex resultMutex;
+    Tally tally;
+    std::atomic<int> next{0};
+    std::atomic<bool> decided{false};
+    std::string verdict;
+
+    // Each worker owns one pair of engines for all its games, so memory stays
+    // constant however many games are played
+    auto work = [&]() {
+        Worker worker(opt);
+        std::vector<std::string> san;
+        san.reserve(MAX_GAME_PLIES);
+        for (int game = next++; game < opt.games && !decided; game = next++) {
+            const int pair = game / 2;
+            const int whiteEngine = game % 2;
+            const std::string fen = openings.empty()
+                ? randomOpening(opt.randomPlies, opt.seed * 0x9E3779B97F4A7C15ULL + pair)
+                : openings[pair % openings.size()];
+
+            san.clear();
+            GameResult result = worker.play(fen, whiteEngine, san);
+            const int firstScore = whiteEngine == 0 ? result.whiteScore : 2 - result.whiteScore;
+            std::string text = formatPgn(opt, game + 1, fen, whiteEngine, san, result, date);
+
+            std::lock_guard<std::mutex> lock(resultMutex);
+            if (pgn.is_open()) pgn << text << std::flush;
+            if (firstScore == 2) tally.wins++;
+            else if (firstScore == 1) tally.draws++;
+            else tally.losses++;
+
+            const double score = tally.score();
+            const double margin = 1.959964 * std::sqrt(tally.variance() / tally.games());
+            const double elo = scoreToElo(score);
+            std::cout << "Game " << std::setw(5) << game + 1 << " " << std::setw(7) << resultText(result.whiteScore)
+                      << " " << std::left << std::setw(21) << result.reason << std::right
+                      << " +" << tally.wins << " =" << tally.draws << " -" << tally.losses
+                      << "  Elo " << std::fixed << std::setprecision(1) << elo
+                      << " +/- " << (scoreToElo(std::min(score + margin, 1.0)) - scoreToElo(std::max(score - margin, 0.0))) / 2;
+            if (opt.sprt) {
+                const double llr = logLikelihoodRatio(tally, opt.elo0, opt.elo1);
+                std::cout << "  LLR " << std::setprecision(2) << llr << " [" << lowerBound << ", " << upperBound << "]";
+                if (!decided && (llr <= lowerBound || llr >= upperBound)) {
+                    verdict = llr >= upperBound ? "H1 accepted" : "H0 accepted";
+                    decided = true;
+                }
+            }
+            std::cout << "\n" << std::flush;
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (int i = 1; i < std::min(opt.concurrency, opt.games); i++) pool.emplace_back(work);
+    work();
+    for (std::thread& t : pool) t.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "\n" << opt.engines[0].name << " vs " << opt.engines[1].name << ": "
+              << tally.games() << " games, +" << tally.wins << " =" << tally.draws << " -" << tally.losses
+              << std::fixed << std::setprecision(1) << " (" << 100 * tally.score() << "%)\n"
+              << "Elo: " << scoreToElo(tally.score()) << "\n";
+    if (opt.sprt) {
+        std::cout << "SPRT elo0=" << opt.elo0 << " elo1=" << opt.elo1 << ": "
+                  << (verdict.empty() ? "no decision yet" : verdict) << std::setprecision(2)
+                  << " (LLR " << logLikelihoodRatio(tally, opt.elo0, opt.elo1) << ")\n";
+    }
+    std::cout << "Time: " << static_cast<long long>(seconds * 1000) << " ms, "
+              << std::setprecision(2) << (seconds > 0 ? tally.games() / seconds : 0) << " games/s\n";
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include "AI.hpp"
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Fixed middlegame and endgame positions so runs can be compared between builds.
+const char* benchPositions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 0 8",
+    "2r3k1/pp3ppp/4pn2/8/3P4/P4N2/1P3PPP/2R3K1 w - - 0 25",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "8/8/4k3/3p4/3P4/4K3/8/8 w - - 0 1",
+};
+
+struct Options {
+    int depth = 6;
+    int moveTime = 0;
+    int maxThreads = 0;
+    int hashMB = 64;
+};
+
+void printUsage() {
+    std::cout << "Usage: smp_bench [options]\n"
+              << "  --depth N        time to reach this depth in every position (default 6)\n"
+              << "  --movetime MS    instead search each position for MS and report the depth reached\n"
+              << "  --max-threads N  largest thread count to measure (default: all cores)\n"
+              << "  --hash MB        transposition table size (default 64)\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--depth" && hasValue) opt.depth = std::atoi(argv[++i]);
+        else if (arg == "--movetime" && hasValue) opt.moveTime = std::atoi(argv[++i]);
+        else if (arg == "--max-threads" && hasValue) opt.maxThreads = std::atoi(argv[++i]);
+        else if (arg == "--hash" && hasValue) opt.hashMB = std::atoi(argv[++i]);
+        else return false;
+    }
+    if (opt.maxThreads <= 0) opt.maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    return opt.depth > 0 && opt.hashMB > 0;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) {
+        printUsage();
+        return 2;
+    }
+
+    std::cout << (opt.moveTime > 0 ? "movetime " + std::to_string(opt.moveTime) + " ms"
+                                   : "depth " + std::to_string(opt.depth))
+              << ", " << sizeof(benchPositions) / sizeof(benchPositions[0]) << " positions, hash " << opt.hashMB << " MB\n\n"
+              << std::left << std::setw(9) << "threads" << std::setw(12) << "time ms" << std::setw(10) << "speedup"
+              << std::setw(14) << "nodes" << std::setw(12) << "nps" << std::setw(11) << "avg depth"
+              << "first-move cutoffs\n";
+
+    // Powers of two, plus the maximum itself when it is not one
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < opt.maxThreads; threads *= 2) threadCounts.push_back(threads);
+    threadCounts.push_back(opt.maxThreads);
+
+    double baseTime = 0;
+    for (int threads : threadCounts) {
+        std::uint64_t nodes = 0;
+        SearchStats stats;
+        double seconds = 0;
+        int depthSum = 0;
+        int count = 0;
+
+        for (const char* fen : benchPositions) {
+            Board board;
+            board.fromFEN(fen);
+            AI ai(board.getTurn());
+            ai.setHashSize(opt.hashMB);
+            ai.setThreads(threads);
+
+            SearchLimits limits;
+            if (opt.moveTime > 0) limits.moveTime = opt.moveTime;
+            else limits.depth = opt.depth;
+
+            auto start = std::chrono::steady_clock::now();
+            SearchResult r = ai.search(board, limits);
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            nodes += r.nodes;
+            stats.add(r.stats);
+            depthSum += r.depth;
+            count++;
+        }
+
+        if (threads == 1) baseTime = seconds;
+        // At fixed depth the speedup is time-to-depth; at fixed time it is not meaningful
+        double speedup = (opt.moveTime > 0 || seconds <= 0) ? 0 : baseTime / seconds;
+        std::cout << std::left << std::setw(9) << threads
+                  << std::setw(12) << static_cast<long long>(seconds * 1000)
+                  << std::setw(10) << std::fixed << std::setprecision(2) << speedup
+                  << std::setw(14) << nodes
+                  << std::setw(12) << static_cast<long long>(seconds > 0 ? nodes / seconds : 0)
+                  << std::setw(11) << std::setprecision(2) << static_cast<double>(depthSum) / count
+                  << std::setprecision(1);
+        // Cutoffs are only counted in builds with search statistics
+        if (SEARCH_STATS_ENABLED) std::cout << 100.0 * stats.firstMoveCutoffRate() << "%\n";
+        else std::cout << "-\n";
+    }
+    return 0;
+}
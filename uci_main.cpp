@@ -0,0 +1,9 @@
+#include "UciEngine.hpp"
+#include <iostream>
+
+int main() {
+    std::ios::sync_with_stdio(false);
+    UciEngine engine(std::cin, std::cout);
+    engine.run();
+    return 0;
+}